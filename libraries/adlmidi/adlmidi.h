@@ -562,6 +562,17 @@ extern ADLMIDI_DECLSPEC void adl_setLoopEnabled(struct ADL_MIDIPlayer *device, i
  */
 extern ADLMIDI_DECLSPEC void adl_setSoftPanEnabled(struct ADL_MIDIPlayer *device, int softPanEn);
 
+/**
+ * @brief Render multiple emulated chips on helper threads
+ *
+ * Every chip is rendered into its own buffer and mixed in a fixed order,
+ * so the output is identical to the single-threaded rendering.
+ *
+ * @param device Instance of the library
+ * @param threaded 0 - disabled, 1 - enabled
+ */
+extern ADLMIDI_DECLSPEC void adl_setThreadedChips(struct ADL_MIDIPlayer *device, int threaded);
+
 /**
  * @brief [DEPRECATED] Enable or disable Logarithmic volume changer
  *
@@ -60,6 +60,9 @@ static const unsigned OPLBase = 0x388;
 #   ifndef ADLMIDI_DISABLE_JAVA_EMULATOR
 #       include "chips/java_opl3.h"
 #   endif
+
+// Parallel rendering of multiple chips
+#   include "chips/opl_chip_threads.h"
 #endif
 
 static const unsigned adl_emulatorSupport = 0
@@ -866,6 +869,7 @@ OPL3::OPL3() :
     m_deepVibratoMode(false),
     m_rhythmMode(false),
     m_softPanning(false),
+    m_threadedChips(false),
     m_masterVolume(MasterVolumeDefault),
     m_musicMode(MODE_MIDI),
     m_volumeScale(VOLUME_Generic)
@@ -1714,6 +1718,30 @@ void OPL3::clearChips()
         m_chips[i].reset(NULL);
     m_chips.clear();
 }
+
+void OPL3::generate32(int32_t *output, size_t frames)
+{
+    size_t chips = m_chips.size();
+    if(chips == 1)
+        m_chips[0]->generate32(output, frames);
+#   if !defined(ADLMIDI_AUDIO_TICK_HANDLER) // the tick handler calls back into the player
+    else if(m_threadedChips && chips > 1)
+    {
+        if(!m_chipThreads.get())
+            m_chipThreads.reset(new OPLChipThreads);
+        m_chipPtrs.resize(chips);
+        for(size_t i = 0; i < chips; ++i)
+            m_chipPtrs[i] = m_chips[i].get();
+        m_chipThreads->generate(m_chipPtrs.data(), chips, output, frames);
+    }
+#   endif
+    else
+    {
+        std::memset(output, 0, frames * 2 * sizeof(output[0]));
+        for(size_t i = 0; i < chips; ++i)
+            m_chips[i]->generateAndMix32(output, frames);
+    }
+}
 #endif
 
 void OPL3::reset(int emulator, unsigned long PCM_RATE, void *audioTickHandler)
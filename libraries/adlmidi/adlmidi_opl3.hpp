@@ -40,6 +40,8 @@
 #define NUM_OF_2x2_CHANNELS             9
 #define NUM_OF_RM_CHANNELS              5
 
+class OPLChipThreads;
+
 /**
  * @brief OPL3 Chip management class
  */
@@ -62,6 +64,10 @@ public:
 #ifndef ADLMIDI_HW_OPL
     //! Running chip emulators
     std::vector<AdlMIDI_SPtr<OPLChipBase > > m_chips;
+    //! Helper threads to render the chips in parallel, created on first use
+    AdlMIDI_UPtr<OPLChipThreads> m_chipThreads;
+    //! Plain chip pointers handed to the helper threads
+    std::vector<OPLChipBase *> m_chipPtrs;
 #endif
 
 private:
@@ -110,6 +116,8 @@ public:
     bool m_runAtPcmRate;
     //! Enable soft panning
     bool m_softPanning;
+    //! Render multiple chips on helper threads
+    bool m_threadedChips;
     //! Master volume, controlled via SysEx (0...127)
     uint8_t m_masterVolume;
 
@@ -323,6 +331,13 @@ public:
      * @brief Clean up all running emulated chip instances
      */
     void clearChips();
+
+    /**
+     * @brief Generate and mix the output of all chips
+     * @param output Stereo output buffer, overwritten
+     * @param frames Number of stereo frames to generate
+     */
+    void generate32(int32_t *output, size_t frames);
     #endif
 
     /**
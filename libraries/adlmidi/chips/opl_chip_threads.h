@@ -0,0 +1,187 @@
+/*
+ * Helper threads for rendering several emulated chips in parallel
+ *
+ * Every chip is rendered into its own buffer and the buffers are mixed
+ * afterwards in chip order, so the output does not depend on how the
+ * work was split between the threads.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef OPL_CHIP_THREADS_H
+#define OPL_CHIP_THREADS_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+#include "opl_chip_base.h"
+
+class OPLChipThreads
+{
+    OPLChipThreads(const OPLChipThreads &);
+    OPLChipThreads &operator=(const OPLChipThreads &);
+
+    //! Work description of one block
+    struct Block
+    {
+        OPLChipBase *const *chips;
+        size_t numChips;
+        size_t frames;
+        int32_t *output;
+        uint32_t generation;
+    };
+
+    std::vector<std::thread> m_threads;
+    std::vector<std::vector<int32_t> > m_buffers;
+
+    //! Current block, protected by m_lock
+    Block m_block;
+    //! Generation in the upper, next chip to pick up in the lower 32 bits
+    std::atomic<uint64_t> m_next;
+    //! Number of chips finished in the current block
+    std::atomic<size_t> m_done;
+
+    std::mutex m_lock;
+    std::condition_variable m_wake;
+    bool m_quit;
+
+    /**
+     * @brief Picks up chips until all of the block's chips are taken.
+     * A thread that arrives late never takes a chip of a later block,
+     * because the ticket carries the block's generation.
+     */
+    void work(const Block &block)
+    {
+        uint64_t ticket = m_next.load();
+        for(;;)
+        {
+            if(uint32_t(ticket >> 32) != block.generation || size_t(ticket & 0xFFFFFFFF) >= block.numChips)
+                return;
+            if(!m_next.compare_exchange_weak(ticket, ticket + 1))
+                continue;
+            size_t chip = size_t(ticket & 0xFFFFFFFF);
+            int32_t *buf = chip == 0 ? block.output : m_buffers[chip].data();
+            block.chips[chip]->generate32(buf, block.frames);
+            m_done.fetch_add(1);
+            ticket = m_next.load();
+        }
+    }
+
+    void threadMain()
+    {
+        uint32_t seen = 0;
+        for(;;)
+        {
+            Block block;
+            {
+                std::unique_lock<std::mutex> lock(m_lock);
+                while(!m_quit && m_block.generation == seen)
+                    m_wake.wait(lock);
+                if(m_quit)
+                    return;
+                block = m_block;
+                seen = block.generation;
+            }
+            work(block);
+        }
+    }
+
+public:
+    OPLChipThreads() :
+        m_next(0),
+        m_done(0),
+        m_quit(false)
+    {
+        m_block.chips = NULL;
+        m_block.numChips = 0;
+        m_block.frames = 0;
+        m_block.output = NULL;
+        m_block.generation = 0;
+    }
+
+    ~OPLChipThreads()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_quit = true;
+        }
+        m_wake.notify_all();
+        for(size_t i = 0; i < m_threads.size(); ++i)
+            m_threads[i].join();
+    }
+
+    /**
+     * @brief Renders and mixes a block from all chips
+     * @param chips Chip emulators
+     * @param numChips Number of chips, must be at least 2
+     * @param output Stereo output, overwritten with the mix
+     * @param frames Number of stereo frames
+     */
+    void generate(OPLChipBase *const *chips, size_t numChips, int32_t *output, size_t frames)
+    {
+        // The calling thread renders as well, so one thread less than chips is needed.
+        size_t wantThreads = numChips - 1;
+        size_t cores = std::thread::hardware_concurrency();
+        if(cores == 0)
+            cores = 2;
+        if(wantThreads > cores - 1)
+            wantThreads = cores - 1;
+        while(m_threads.size() < wantThreads)
+            m_threads.push_back(std::thread(&OPLChipThreads::threadMain, this));
+        if(m_buffers.size() < numChips)
+            m_buffers.resize(numChips);
+        for(size_t i = 1; i < numChips; ++i)
+        {
+            if(m_buffers[i].size() < frames * 2)
+                m_buffers[i].resize(frames * 2);
+        }
+
+        Block block;
+        {
+            std::lock_guard<std::mutex> lock(m_lock);
+            m_block.chips = chips;
+            m_block.numChips = numChips;
+            m_block.frames = frames;
+            m_block.output = output;
+            m_block.generation++;
+            block = m_block;
+            m_done.store(0);
+            m_next.store(uint64_t(block.generation) << 32);
+        }
+        m_wake.notify_all();
+
+        work(block);
+        while(m_done.load() < numChips)
+            std::this_thread::yield();
+
+        // Mix in fixed chip order
+        for(size_t i = 1; i < numChips; ++i)
+        {
+            const int32_t *buf = m_buffers[i].data();
+            for(size_t j = 0; j < frames * 2; ++j)
+                output[j] += buf[j];
+        }
+    }
+};
+
+#endif // OPL_CHIP_THREADS_H
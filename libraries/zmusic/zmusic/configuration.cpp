@@ -327,6 +327,10 @@ DLL_EXPORT bool ChangeMusicSettingInt(EIntConfigKey key, MusInfo *currSong, int
 			ChangeAndReturn(adlConfig.adl_volume_model, value, pRealValue);
 			return devType() == MDEV_ADL;
 
+		case zmusic_adl_threaded_chips: 
+			ChangeAndReturn(adlConfig.adl_threaded_chips, value, pRealValue);
+			return devType() == MDEV_ADL;
+
 		case zmusic_fluid_reverb: 
 			if (currSong != NULL)
 				currSong->ChangeSettingInt("fluidsynth.synth.reverb.active", value);
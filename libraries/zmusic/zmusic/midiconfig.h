@@ -17,6 +17,7 @@ struct ADLConfig
 	int adl_run_at_pcm_rate = 0;
 	int adl_fullpan = 1;
 	int adl_use_custom_bank = false;
+	int adl_threaded_chips = true;
 	std::string adl_custom_bank;
 };
 
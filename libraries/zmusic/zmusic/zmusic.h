@@ -79,6 +79,7 @@ enum EIntConfigKey
 	zmusic_adl_bank,
 	zmusic_adl_use_custom_bank,
 	zmusic_adl_volume_model,
+	zmusic_adl_threaded_chips,
 
 	zmusic_fluid_reverb,
 	zmusic_fluid_chorus,
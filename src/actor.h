@@ -628,6 +628,18 @@ struct FLinkContext
 	msecnode_t *render_list = nullptr;
 };
 
+// Remembers how far an actor can move before the sectors it touches can
+// change, so that P_CreateSecNodeList can skip the blockmap walk.
+struct FSecNodeCache
+{
+	msecnode_t *list;		// the list this is valid for
+	sector_t *sector;
+	DVector2 pos;
+	double radius;
+	double slack;
+	int polygeneration;
+};
+
 struct FDropItem
 {
 	FDropItem *Next;
@@ -1184,6 +1196,8 @@ public:
 	struct msecnode_t	*touching_sectorportallist;		// same for cross-sectorportal rendering
 	struct portnode_t	*touching_lineportallist;		// and for cross-lineportal
 	struct msecnode_t	*touching_rendersectors; // this is the list of sectors that this thing interesects with it's max(radius, renderradius).
+	FSecNodeCache		sectorlistcache;
+	FSecNodeCache		rendersectorcache;
 	int validcount;
 
 
@@ -1050,6 +1050,7 @@ void D_Display ()
 		GSnd->SetSfxPaused(false, 1);
 	}
 	screen->End2D();
+	TexMan.TrimPixelCache();
 	cycles.Unclock();
 	FrameCycles = cycles;
 }
@@ -78,6 +78,7 @@
 #include "vm.h"
 #include "gstrings.h"
 #include "s_music.h"
+#include "serializer.h"
 
 EXTERN_CVAR (Int, disableautosave)
 EXTERN_CVAR (Int, autosavecount)
@@ -361,6 +362,7 @@ void Net_ClearBuffers ()
 	maketic = 0;
 
 	lastglobalrecvtime = 0;
+	Net_ResetWorldChecksum();
 }
 
 //
@@ -770,7 +772,7 @@ void GetPackets (void)
 	int numtics;
 	int retransmitfrom;
 	int k;
-	uint8_t playerbytes[MAXNETNODES];
+	uint8_t playerbytes[MAXPLAYERS];
 	int numplayers;
 								 
 	while ( HGetPacket() )
@@ -1862,6 +1864,36 @@ static void TicStabilityEnd()
 	stabilityticduration = std::min(stabilityendtime - stabilitystarttime, (uint64_t)1'000'000);
 }
 
+//
+// RunDemoSeekTics
+//
+// Runs as many tics as fit into a frame's worth of time while a demo is
+// being fast-forwarded, so the screen still gets updated occasionally.
+//
+static void RunDemoSeekTics ()
+{
+	uint64_t start = I_msTime();
+
+	P_UnPredictPlayer();
+	do
+	{
+		if (advancedemo)
+		{
+			D_DoAdvanceDemo ();
+		}
+		C_Ticker ();
+		M_Ticker ();
+		G_Ticker ();
+		gametic++;
+		maketic++;
+		Net_NewMakeTic ();
+	} while (G_DemoSeeking() && I_msTime() - start < 50);
+
+	resendto[0] = nettics[0] = (maketic / ticdup);
+	P_PredictPlayer(&players[consoleplayer]);
+	S_UpdateSounds (players[consoleplayer].camera);
+}
+
 //
 // TryRunTics
 //
@@ -1898,6 +1930,12 @@ void TryRunTics (void)
 	if (pauseext)
 		return;
 
+	if (G_DemoSeeking())
+	{
+		RunDemoSeekTics();
+		return;
+	}
+
 	lowtic = INT_MAX;
 	numplaying = 0;
 	for (i = 0; i < doomcom.numnodes; i++)
@@ -2184,6 +2222,184 @@ static int RemoveClass(const PClass *cls)
 	return removecount;
 
 }
+
+//==========================================================================
+//
+// World checksums
+//
+// The per-player consistancy value only covers the player's position,
+// so a desync caused by monsters or sectors only shows up once it has
+// spread to a player. With net_worldchecksum set, a rolling hash of the
+// simulated world is kept for a few subsystems, and every node sends its
+// hashes through the command stream every net_worldchecksum tics. This
+// also stores them in recorded demos. Received hashes are compared with
+// the local history, and the first mismatch is reported together with
+// the subsystems that diverged.
+//
+//==========================================================================
+
+enum
+{
+	WCS_Positions,
+	WCS_Health,
+	WCS_States,
+	WCS_Random,
+	WCS_Sectors,
+	NUM_WORLDCHECKSUMS,
+	WORLDCHECKSUMTICS = 256		// how many tics of history to keep
+};
+
+static const char *WorldChecksumNames[NUM_WORLDCHECKSUMS] =
+{
+	"actor positions", "actor health", "actor states", "random seeds", "sector heights"
+};
+
+struct FWorldChecksum
+{
+	int Tic;
+	uint32_t Sums[NUM_WORLDCHECKSUMS];
+};
+
+static FWorldChecksum WorldChecksums[WORLDCHECKSUMTICS];
+static uint32_t WorldSums[NUM_WORLDCHECKSUMS];
+static int WorldChecksumTic;
+static bool WorldDesyncReported;
+
+CUSTOM_CVAR(Int, net_worldchecksum, 0, CVAR_SERVERINFO | CVAR_NOSAVE)	// tics between checksums, 0 = off
+{
+	if (self < 0) self = 0;
+	// All nodes see this change on the same tic, so they restart in sync.
+	Net_ResetWorldChecksum();
+}
+
+static inline uint32_t WorldHash(uint32_t hash, uint32_t value)
+{
+	return (hash ^ value) * 16777619u;
+}
+
+static inline uint32_t WorldHash(uint32_t hash, double value)
+{
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return WorldHash(WorldHash(hash, uint32_t(bits)), uint32_t(bits >> 32));
+}
+
+void Net_ResetWorldChecksum()
+{
+	memset(WorldSums, 0, sizeof(WorldSums));
+	for (auto &entry : WorldChecksums)
+	{
+		entry.Tic = -1;
+	}
+	WorldChecksumTic = 0;
+	WorldDesyncReported = false;
+}
+
+//==========================================================================
+//
+// Demo keyframes need the running hashes to resume checking after a seek.
+//
+//==========================================================================
+
+void Net_SerializeWorldChecksum(FSerializer &arc)
+{
+	arc("worldchecksumtic", WorldChecksumTic)
+		.Array("worldchecksums", WorldSums, NUM_WORLDCHECKSUMS);
+
+	if (arc.isReading())
+	{
+		for (auto &entry : WorldChecksums)
+		{
+			entry.Tic = -1;
+		}
+		WorldDesyncReported = false;
+	}
+}
+
+//==========================================================================
+//
+// Called by G_Ticker after the level has been ticked.
+//
+//==========================================================================
+
+void Net_WorldChecksumTicker()
+{
+	if (net_worldchecksum <= 0)
+	{
+		return;
+	}
+
+	uint32_t sums[NUM_WORLDCHECKSUMS];
+	for (auto &sum : sums) sum = 2166136261u;
+
+	TThinkerIterator<AActor> it;
+	AActor *ac;
+	while ((ac = it.Next()) != nullptr)
+	{
+		sums[WCS_Positions] = WorldHash(WorldHash(WorldHash(sums[WCS_Positions], ac->X()), ac->Y()), ac->Z());
+		sums[WCS_Health] = WorldHash(sums[WCS_Health], uint32_t(ac->health));
+		sums[WCS_States] = WorldHash(sums[WCS_States], uint32_t(ac->sprite) | (ac->frame << 16));
+		sums[WCS_States] = WorldHash(sums[WCS_States], uint32_t(ac->tics));
+	}
+	sums[WCS_Random] = WorldHash(sums[WCS_Random], FRandom::StaticSumSeeds());
+	for (auto &sec : level.sectors)
+	{
+		sums[WCS_Sectors] = WorldHash(WorldHash(sums[WCS_Sectors], sec.floorplane.fD()), sec.ceilingplane.fD());
+	}
+
+	// Fold this tic into the running hashes so that a divergence stays
+	// visible even if it only lasted for tics that were not sent.
+	FWorldChecksum &entry = WorldChecksums[WorldChecksumTic % WORLDCHECKSUMTICS];
+	entry.Tic = WorldChecksumTic;
+	for (int i = 0; i < NUM_WORLDCHECKSUMS; i++)
+	{
+		entry.Sums[i] = WorldSums[i] = WorldHash(WorldSums[i], sums[i]);
+	}
+
+	if (!demoplayback && (netgame || demorecording) && WorldChecksumTic % net_worldchecksum == 0)
+	{
+		Net_WriteByte(DEM_WORLDCHECKSUM);
+		Net_WriteLong(WorldChecksumTic);
+		for (auto sum : entry.Sums)
+		{
+			Net_WriteLong(sum);
+		}
+	}
+	WorldChecksumTic++;
+}
+
+static void Net_CheckWorldChecksum(int player, int tic, const uint32_t *sums)
+{
+	const FWorldChecksum &entry = WorldChecksums[tic % WORLDCHECKSUMTICS];
+
+	if (WorldDesyncReported || tic < 0 || entry.Tic != tic)
+	{
+		return;
+	}
+
+	FString diverged;
+	for (int i = 0; i < NUM_WORLDCHECKSUMS; i++)
+	{
+		if (entry.Sums[i] != sums[i])
+		{
+			if (diverged.IsNotEmpty()) diverged += ", ";
+			diverged += WorldChecksumNames[i];
+		}
+	}
+	if (diverged.IsNotEmpty())
+	{
+		WorldDesyncReported = true;
+		if (demoplayback)
+		{
+			Printf(PRINT_HIGH, TEXTCOLOR_RED "Demo desync at checksum tic %d: %s\n", tic, diverged.GetChars());
+		}
+		else
+		{
+			Printf(PRINT_HIGH, TEXTCOLOR_RED "Desync with %s at checksum tic %d: %s\n", players[player].userinfo.GetName(), tic, diverged.GetChars());
+		}
+	}
+}
+
 // [RH] Execute a special "ticcmd". The type byte should
 //		have already been read, and the stream is positioned
 //		at the beginning of the command's actual data.
@@ -2754,6 +2970,18 @@ void Net_DoCommand (int type, uint8_t **stream, int player)
 		}
 		break;
 
+	case DEM_WORLDCHECKSUM:
+		{
+			int tic = ReadLong(stream);
+			uint32_t sums[NUM_WORLDCHECKSUMS];
+			for (auto &sum : sums)
+				sum = ReadLong(stream);
+			// During playback the recorded checksums are checked against the replay.
+			if (player != consoleplayer || demoplayback)
+				Net_CheckWorldChecksum(player, tic, sums);
+		}
+		break;
+
 	default:
 		I_Error ("Unknown net command: %d", type);
 		break;
@@ -2853,6 +3081,10 @@ void Net_SkipCommand (int type, uint8_t **stream)
 			skip = 8;
 			break;
 
+		case DEM_WORLDCHECKSUM:
+			skip = 4 + 4 * NUM_WORLDCHECKSUMS;
+			break;
+
 		case DEM_GENERICCHEAT:
 		case DEM_DROPPLAYER:
 		case DEM_ADDCONTROLLER:
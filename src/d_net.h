@@ -32,6 +32,8 @@
 #include "doomdef.h"
 #include "d_protocol.h"
 
+class FSerializer;
+
 
 //
 // Network play related stuff.
@@ -42,11 +44,15 @@
 //
 
 #define DOOMCOM_ID		0x12345678l
-#define MAXNETNODES		8	// max computers in a game
+#define MAXNETNODES		MAXPLAYERS	// max computers in a game, every node hosts at least one player
 #define BACKUPTICS		36	// number of tics to remember
 #define MAXTICDUP		5
 #define LOCALCMDTICS	(BACKUPTICS*MAXTICDUP)
 
+// The setup handshake tracks nodes in a 32 bit mask and player numbers
+// share their byte with PL_DRONE, so this is as far as the protocol goes.
+static_assert(MAXNETNODES < 32, "Too many net nodes for the setup handshake");
+
 
 #ifdef DJGPP
 // The DOS drivers provide a pretty skimpy buffer.
@@ -134,6 +140,10 @@ void Net_WriteBytes (const uint8_t *, int len);
 void Net_DoCommand (int type, uint8_t **stream, int player);
 void Net_SkipCommand (int type, uint8_t **stream);
 
+void Net_ResetWorldChecksum ();
+void Net_WorldChecksumTicker ();
+void Net_SerializeWorldChecksum (FSerializer &arc);
+
 void Net_ClearBuffers ();
 
 
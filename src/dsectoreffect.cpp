@@ -117,6 +117,23 @@ void DMover::StopInterpolation(bool force)
 	}
 }
 
+//
+// Moves a plane the way MoveFloor/MoveCeiling would, but without checking
+// for or moving anything inside the sector. Used by P_PredictPlayer, which
+// restores the plane afterwards. Returns true if the destination was reached.
+//
+bool DMover::PredictPlane(int pos, double speed, double dest, int direction)
+{
+	secplane_t &plane = m_Sector->GetSecPlane(pos);
+	double lastpos = plane.fD();
+	double movedest = plane.GetChangedHeight(direction * speed);
+	bool pastdest = ((pos == sector_t::floor) == (direction < 0)) ? movedest >= dest : movedest <= dest;
+
+	plane.setD(pastdest ? dest : movedest);
+	m_Sector->ChangePlaneTexZ(pos, plane.HeightDiff(lastpos));
+	return pastdest;
+}
+
 IMPLEMENT_CLASS(DMovingFloor, true, false)
 
 
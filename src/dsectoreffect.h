@@ -34,8 +34,13 @@ protected:
 public:
 	void StopInterpolation(bool force = false);
 
+	// Advances the sector's planes by one tic without touching any actors
+	// or the mover's own state. Only used for client-side prediction.
+	virtual void Predict() {}
+
 protected:
 	DMover () {}
+	bool PredictPlane(int pos, double speed, double dest, int direction);
 	
 	void Serialize(FSerializer &arc);
 	void OnDestroy() override;
@@ -598,6 +598,11 @@ struct ProfileInfo
 TMap<FName, ProfileInfo> Profiles;
 
 
+int DThinker::GetThinkCount()
+{
+	return ThinkCount;
+}
+
 void DThinker::RunThinkers ()
 {
 	int i, count;
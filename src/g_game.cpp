@@ -92,6 +92,8 @@
 #include "p_conversation.h"
 
 #include <zlib.h>
+#include "LzmaEnc.h"
+#include "LzmaDec.h"
 
 #include "g_hub.h"
 #include "g_levellocals.h"
@@ -107,6 +109,15 @@ extern bool NoMenu; //[GEC]
 static FRandom pr_dmspawn ("DMSpawn");
 static FRandom pr_pspawn ("PlayerSpawn");
 
+extern ISzAlloc g_Alloc;
+
+// Compression methods stored in the COMP chunk of a demo.
+enum
+{
+	DEMOCOMP_ZLIB,
+	DEMOCOMP_LZMA
+};
+
 const int SAVEPICWIDTH = 216;
 const int SAVEPICHEIGHT = 162;
 
@@ -114,6 +125,9 @@ bool	G_CheckDemoStatus (void);
 void	G_ReadDemoTiccmd (ticcmd_t *cmd, int player);
 void	G_WriteDemoTiccmd (ticcmd_t *cmd, int player, int buf);
 void	G_PlayerReborn (int player);
+void	G_ClearDemoKeyframes ();
+static void G_DemoKeyframeTicker ();
+static void G_AdvanceDemoTic ();
 
 void	G_DoNewGame (void);
 void	G_DoLoadGame (void);
@@ -138,6 +152,7 @@ CVAR (String, save_dir, "", CVAR_ARCHIVE|CVAR_GLOBALCONFIG);
 CVAR (Bool, cl_waitforsave, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);
 CVAR (Bool, enablescriptscreenshot, false, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);
 EXTERN_CVAR (Float, con_midtime);
+EXTERN_CVAR (Bool, sv_fastchangesector)
 
 //==========================================================================
 //
@@ -190,6 +205,7 @@ int 			gametic;
 time_t 			epochoffset = 0;		// epoch start in seconds (0 = January 1st, 1970)
 
 CVAR(Bool, demo_compress, true, CVAR_ARCHIVE|CVAR_GLOBALCONFIG);
+CVAR(Bool, demo_compresslzma, true, CVAR_ARCHIVE|CVAR_GLOBALCONFIG);	// LZMA instead of zlib for the demo BODY
 FString			newdemoname;
 FString			newdemomap;
 FString			demoname;
@@ -200,6 +216,7 @@ int				demover;
 uint8_t*			demobuffer;
 uint8_t*			demo_p;
 uint8_t*			democompspot;
+static int		democompmethod;
 uint8_t*			demobodyspot;
 size_t			maxdemosize;
 uint8_t*			zdemformend;			// end of FORM ZDEM chunk
@@ -1182,6 +1199,11 @@ void G_Ticker ()
 		}
 	}
 
+	if (demoplayback && gamestate == GS_LEVEL && gameaction == ga_nothing)
+	{
+		G_DemoKeyframeTicker();
+	}
+
 	// get commands, check consistancy, and build new consistancy check
 	int buf = (gametic/ticdup)%BACKUPTICS;
 
@@ -1248,6 +1270,11 @@ void G_Ticker ()
 		}
 	}
 
+	if (demoplayback)
+	{
+		G_AdvanceDemoTic();
+	}
+
 	// [ZZ] also tick the UI part of the events
 	E_UiTick();
 	C_RunDelayedCommands();
@@ -1258,6 +1285,7 @@ void G_Ticker ()
 	case GS_LEVEL:
 		P_Ticker ();
 		AM_Ticker ();
+		Net_WorldChecksumTicker ();
 		break;
 
 	case GS_TITLELEVEL:
@@ -1883,6 +1911,56 @@ static void LoadGameError(const char *label, const char *append = "")
 	Printf ("%s %s\n", message.GetChars(), append);
 }
 
+//==========================================================================
+//
+// Writes everything that is not part of a level snapshot.
+// Shared by savegames and demo keyframes.
+//
+//==========================================================================
+
+static void G_WriteGameGlobals(FSerializer &arc)
+{
+	// Intermission stats for hubs
+	G_SerializeHub(arc);
+	C_SerializeCVars(arc, "servercvars", CVAR_SERVERINFO);
+
+	if (level.time != 0 || level.maptime != 0)
+	{
+		int tic = TICRATE;
+		arc("ticrate", tic);
+		arc("leveltime", level.time);
+	}
+
+	STAT_Serialize(arc);
+	FRandom::StaticWriteRNGState(arc);
+	P_WriteACSDefereds(arc);
+	P_WriteACSVars(arc);
+	G_WriteVisited(arc);
+
+	if (NextSkill != -1)
+	{
+		arc("nextskill", NextSkill);
+	}
+}
+
+//==========================================================================
+//
+// Reads the part of the globals that must be restored after the
+// level has been set up again.
+//
+//==========================================================================
+
+static void G_ReadGameGlobals(FSerializer &arc)
+{
+	STAT_Serialize(arc);
+	FRandom::StaticReadRNGState(arc);
+	P_ReadACSDefereds(arc);
+	P_ReadACSVars(arc);
+
+	NextSkill = -1;
+	arc("nextskill", NextSkill);
+}
+
 void G_DoLoadGame ()
 {
 	bool hidecon;
@@ -2028,13 +2106,7 @@ void G_DoLoadGame ()
 	demoplayback = demoplaybacksave;
 	savegamerestore = false;
 
-	STAT_Serialize(arc);
-	FRandom::StaticReadRNGState(arc);
-	P_ReadACSDefereds(arc);
-	P_ReadACSVars(arc);
-
-	NextSkill = -1;
-	arc("nextskill", NextSkill);
+	G_ReadGameGlobals(arc);
 
 	if (level.info != nullptr)
 		level.info->Snapshot.Clean();
@@ -2317,28 +2389,7 @@ void G_DoSaveGame (bool okForQuicksave, bool forceQuicksave, FString filename, c
 	PutSaveWads (savegameinfo);
 	PutSaveComment (savegameinfo);
 
-	// Intermission stats for hubs
-	G_SerializeHub(savegameglobals);
-	C_SerializeCVars(savegameglobals, "servercvars", CVAR_SERVERINFO);
-
-	if (level.time != 0 || level.maptime != 0)
-	{
-		int tic = TICRATE;
-		savegameglobals("ticrate", tic);
-		savegameglobals("leveltime", level.time);
-	}
-
-	STAT_Serialize(savegameglobals);
-	FRandom::StaticWriteRNGState(savegameglobals);
-	P_WriteACSDefereds(savegameglobals);
-	P_WriteACSVars(savegameglobals);
-	G_WriteVisited(savegameglobals);
-
-
-	if (NextSkill != -1)
-	{
-		savegameglobals("nextskill", NextSkill);
-	}
+	G_WriteGameGlobals(savegameglobals);
 
 	auto picdata = savepic.GetBuffer();
 	FCompressedBuffer bufpng = { picdata->Size(), picdata->Size(), METHOD_STORED, 0, static_cast<unsigned int>(crc32(0, &(*picdata)[0], picdata->Size())), (char*)&(*picdata)[0] };
@@ -2530,6 +2581,7 @@ void G_BeginRecording (const char *startmap)
 		startmap = level.MapName;
 	}
 	demo_p = demobuffer;
+	Net_ResetWorldChecksum();
 
 	WriteLong (FORM_ID, &demo_p);			// Write FORM ID
 	demo_p += 4;							// Leave space for len
@@ -2538,8 +2590,16 @@ void G_BeginRecording (const char *startmap)
 	// Write header chunk
 	StartChunk (ZDHD_ID, &demo_p);
 	WriteWord (DEMOGAMEVERSION, &demo_p);	// Write ZDoom version
-	*demo_p++ = 2;							// Write minimum version needed to use this demo.
-	*demo_p++ = 3;							// (Useful?)
+	democompmethod = demo_compress && demo_compresslzma ? DEMOCOMP_LZMA : DEMOCOMP_ZLIB;
+	if (democompmethod == DEMOCOMP_LZMA)
+	{
+		WriteWord (DEMOGAMEVERSION, &demo_p);	// Older versions cannot unpack the BODY.
+	}
+	else
+	{
+		*demo_p++ = 2;							// Write minimum version needed to use this demo.
+		*demo_p++ = 3;							// (Useful?)
+	}
 
 	strcpy((char*)demo_p, startmap);		// Write name of map demo was recorded on.
 	demo_p += strlen(startmap) + 1;
@@ -2582,6 +2642,7 @@ void G_BeginRecording (const char *startmap)
 	StartChunk (COMP_ID, &demo_p);
 	democompspot = demo_p;
 	WriteLong (0, &demo_p);
+	WriteLong (democompmethod, &demo_p);
 	FinishChunk (&demo_p);
 
 	// Begin BODY chunk
@@ -2639,6 +2700,7 @@ bool G_ProcessIFFDemo (FString &mapname)
 	int numPlayers = 0;
 	int id, len, i;
 	uLong uncompSize = 0;
+	int compMethod = DEMOCOMP_ZLIB;
 	uint8_t *nextchunk;
 
 	demoplayback = true;
@@ -2699,6 +2761,8 @@ bool G_ProcessIFFDemo (FString &mapname)
 				demo_p += 8;
 			}
 			rngseed = ReadLong (&demo_p);
+			// Demos that don't store this were recorded without it.
+			sv_fastchangesector = false;
 			// Only reset the RNG if this demo is not in conjunction with a savegame.
 			if (mapname[0] != 0)
 			{
@@ -2737,6 +2801,10 @@ bool G_ProcessIFFDemo (FString &mapname)
 
 		case COMP_ID:
 			uncompSize = ReadLong (&demo_p);
+			if (len >= 8)
+			{
+				compMethod = ReadLong (&demo_p);
+			}
 			break;
 		}
 
@@ -2769,10 +2837,34 @@ bool G_ProcessIFFDemo (FString &mapname)
 	if (uncompSize > 0)
 	{
 		uint8_t *uncompressed = (uint8_t*)M_Malloc(uncompSize);
-		int r = uncompress (uncompressed, &uncompSize, demo_p, uLong(zdembodyend - demo_p));
-		if (r != Z_OK)
+		if (compMethod == DEMOCOMP_LZMA)
+		{
+			SizeT destlen = uncompSize;
+			SizeT srclen = zdembodyend - demo_p - LZMA_PROPS_SIZE;
+			ELzmaStatus status;
+			SRes r = zdembodyend - demo_p <= LZMA_PROPS_SIZE ? SZ_ERROR_INPUT_EOF :
+				LzmaDecode(uncompressed, &destlen, demo_p + LZMA_PROPS_SIZE, &srclen, demo_p, LZMA_PROPS_SIZE,
+					LZMA_FINISH_END, &status, &g_Alloc);
+			if (r != SZ_OK || destlen != uncompSize)
+			{
+				Printf ("Could not decompress demo! (LZMA error %d)\n", r);
+				M_Free(uncompressed);
+				return true;
+			}
+		}
+		else if (compMethod == DEMOCOMP_ZLIB)
+		{
+			int r = uncompress (uncompressed, &uncompSize, demo_p, uLong(zdembodyend - demo_p));
+			if (r != Z_OK)
+			{
+				Printf ("Could not decompress demo! %s\n", M_ZLibError(r).GetChars());
+				M_Free(uncompressed);
+				return true;
+			}
+		}
+		else
 		{
-			Printf ("Could not decompress demo! %s\n", M_ZLibError(r).GetChars());
+			Printf ("Demo uses an unknown compression method!\n");
 			M_Free(uncompressed);
 			return true;
 		}
@@ -2816,6 +2908,8 @@ void G_DoPlayDemo (void)
 		}
 	}
 	demo_p = demobuffer;
+	G_ClearDemoKeyframes();
+	Net_ResetWorldChecksum();
 
 	if (singledemo) Printf ("Playing demo %s\n", defdemoname.GetChars());
 
@@ -2909,6 +3003,7 @@ bool G_CheckDemoStatus (void)
 		C_RestoreCVars ();		// [RH] Restore cvars demo might have changed
 		M_Free (demobuffer);
 		demobuffer = NULL;
+		G_ClearDemoKeyframes();
 
 		P_SetupWeapons_ntohton();
 		demoplayback = false;
@@ -2963,9 +3058,32 @@ bool G_CheckDemoStatus (void)
 			// contents of the COMP chunk will be changed to indicate the
 			// uncompressed size of the BODY.
 			uLong len = uLong(demo_p - demobodyspot);
-			uLong outlen = (len + len/100 + 12);
-			Byte *compressed = new Byte[outlen];
-			int r = compress2 (compressed, &outlen, demobodyspot, len, 9);
+			uLong outlen;
+			Byte *compressed;
+			int r;
+
+			if (democompmethod == DEMOCOMP_LZMA)
+			{
+				// The encoded properties go in front of the stream.
+				CLzmaEncProps props;
+				SizeT propsize = LZMA_PROPS_SIZE;
+				SizeT lzmalen = len + len/3 + 128;
+
+				LzmaEncProps_Init(&props);
+				props.level = 9;
+				props.reduceSize = len;
+				props.numThreads = 1;
+				compressed = new Byte[LZMA_PROPS_SIZE + lzmalen];
+				r = LzmaEncode(compressed + LZMA_PROPS_SIZE, &lzmalen, demobodyspot, len, &props,
+					compressed, &propsize, 0, nullptr, &g_Alloc, &g_Alloc) == SZ_OK ? Z_OK : Z_DATA_ERROR;
+				outlen = uLong(LZMA_PROPS_SIZE + lzmalen);
+			}
+			else
+			{
+				outlen = (len + len/100 + 12);
+				compressed = new Byte[outlen];
+				r = compress2 (compressed, &outlen, demobodyspot, len, 9);
+			}
 			if (r == Z_OK && outlen < len)
 			{
 				formlen = democompspot;
@@ -3004,6 +3122,326 @@ bool G_CheckDemoStatus (void)
 	return false; 
 }
 
+//==========================================================================
+//
+// Demo keyframes
+//
+// During playback the full game state is archived in memory every
+// demo_keyframeinterval seconds, together with the position in the demo
+// stream it belongs to. Seeking restores the closest keyframe before the
+// target and then runs the game forward without rendering until the
+// target is reached.
+//
+//==========================================================================
+
+CUSTOM_CVAR(Int, demo_keyframeinterval, 30, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
+{
+	if (self < 0) self = 0;
+}
+CUSTOM_CVAR(Int, demo_keyframememory, 256, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)	// in MB, 0 means unlimited
+{
+	if (self < 0) self = 0;
+}
+
+struct FDemoKeyframe
+{
+	int Tic;
+	ptrdiff_t DemoPos;
+	FString MapName;
+	FCompressedBuffer Globals;
+	TArray<level_info_t *> SnapshotLevels;
+	TArray<FCompressedBuffer> Snapshots;
+
+	size_t Size() const
+	{
+		size_t size = Globals.mCompressedSize;
+		for (auto &snap : Snapshots) size += snap.mCompressedSize;
+		return size;
+	}
+
+	void Clean()
+	{
+		Globals.Clean();
+		for (auto &snap : Snapshots) snap.Clean();
+		Snapshots.Clear();
+		SnapshotLevels.Clear();
+	}
+};
+
+static TArray<FDemoKeyframe> DemoKeyframes;
+static size_t DemoKeyframeBytes;
+static int DemoKeyframeSpacing = 1;		// doubles each time the memory cap thins out the keyframes
+static int DemoTic;						// tics played since the demo started
+static int DemoSeekTarget = -1;
+static bool DemoSeekRestore;			// restore a keyframe on the next tic
+static bool DemoSeekMuted;
+static bool DemoKeyframesFailed;
+
+static FCompressedBuffer G_CopyCompressedBuffer(const FCompressedBuffer &src)
+{
+	FCompressedBuffer copy = src;
+	copy.mBuffer = new char[src.mCompressedSize];
+	memcpy(copy.mBuffer, src.mBuffer, src.mCompressedSize);
+	return copy;
+}
+
+static void G_EndDemoSeek()
+{
+	DemoSeekTarget = -1;
+	DemoSeekRestore = false;
+	if (DemoSeekMuted)
+	{
+		GSnd->SetSfxPaused(false, 2);
+		DemoSeekMuted = false;
+	}
+}
+
+void G_ClearDemoKeyframes()
+{
+	for (auto &kf : DemoKeyframes) kf.Clean();
+	DemoKeyframes.Clear();
+	DemoKeyframeBytes = 0;
+	DemoKeyframeSpacing = 1;
+	DemoTic = 0;
+	DemoKeyframesFailed = false;
+	G_EndDemoSeek();
+}
+
+bool G_DemoSeeking()
+{
+	return demoplayback && DemoSeekTarget > DemoTic;
+}
+
+//==========================================================================
+//
+// Drops every other keyframe until the index fits into the memory cap.
+// The first keyframe is always kept so that the start of the demo
+// remains reachable.
+//
+//==========================================================================
+
+static void G_ThinDemoKeyframes()
+{
+	size_t limit = size_t(*demo_keyframememory) << 20;
+
+	while (limit > 0 && DemoKeyframeBytes > limit && DemoKeyframes.Size() > 1)
+	{
+		for (unsigned i = DemoKeyframes.Size() - 1; i > 0; i--)
+		{
+			if (i & 1)
+			{
+				DemoKeyframeBytes -= DemoKeyframes[i].Size();
+				DemoKeyframes[i].Clean();
+				DemoKeyframes.Delete(i);
+			}
+		}
+		DemoKeyframeSpacing *= 2;
+	}
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+static void G_CaptureDemoKeyframe()
+{
+	insave = true;
+	try
+	{
+		G_SnapshotLevel();
+	}
+	catch (CRecoverableError &err)
+	{
+		// Stop taking keyframes for this demo instead of failing on every interval.
+		insave = false;
+		level.info->Snapshot.Clean();
+		Printf(PRINT_HIGH, "Demo keyframe failed: %s\n", err.GetMessage());
+		DemoKeyframesFailed = true;
+		return;
+	}
+	insave = false;
+
+	FDemoKeyframe kf;
+	FSerializer arc;
+
+	arc.OpenWriter(false);
+	SaveVersion = SAVEVER;
+	G_WriteGameGlobals(arc);
+	Net_SerializeWorldChecksum(arc);
+	kf.Globals = arc.GetCompressedOutput();
+	kf.Tic = DemoTic;
+	kf.DemoPos = demo_p - demobuffer;
+	kf.MapName = level.MapName;
+
+	// Hub levels visited earlier keep their snapshots in the level infos,
+	// so those need to be part of the keyframe as well.
+	for (auto &info : wadlevelinfos)
+	{
+		if (info.Snapshot.mBuffer != nullptr && &info != level.info)
+		{
+			kf.SnapshotLevels.Push(&info);
+			kf.Snapshots.Push(G_CopyCompressedBuffer(info.Snapshot));
+		}
+	}
+	// The current level's snapshot is only needed here so the keyframe can take it over.
+	kf.SnapshotLevels.Push(level.info);
+	kf.Snapshots.Push(level.info->Snapshot);
+	level.info->Snapshot.mBuffer = nullptr;
+	level.info->Snapshot.Clean();
+
+	DemoKeyframeBytes += kf.Size();
+	DemoKeyframes.Push(kf);
+	G_ThinDemoKeyframes();
+}
+
+//==========================================================================
+//
+// Works like G_DoLoadGame, but from an in-memory keyframe.
+//
+//==========================================================================
+
+static void G_RestoreDemoKeyframe(FDemoKeyframe &kf)
+{
+	FSerializer arc;
+	if (!arc.OpenReader(&kf.Globals))
+	{
+		return;
+	}
+
+	G_SerializeHub(arc);
+	bglobal.RemoveAllBots(true);
+	C_SerializeCVars(arc, "servercvars", CVAR_SERVERINFO);
+
+	uint32_t time[2] = { 1,0 };
+
+	arc("ticrate", time[0])
+		("leveltime", time[1]);
+	level.time = Scale(time[1], TICRATE, time[0]);
+
+	G_ClearSnapshots();
+	for (unsigned i = 0; i < kf.Snapshots.Size(); i++)
+	{
+		kf.SnapshotLevels[i]->Snapshot = G_CopyCompressedBuffer(kf.Snapshots[i]);
+	}
+	for (auto &info : wadlevelinfos)
+	{
+		info.flags &= ~LEVEL_VISITED;
+	}
+	G_ReadVisited(arc);
+
+	savegamerestore = true;
+	precache = false;
+	G_InitNew(kf.MapName, false);
+	precache = true;
+	savegamerestore = false;
+	demoplayback = true;
+	usergame = false;
+
+	G_ReadGameGlobals(arc);
+	Net_SerializeWorldChecksum(arc);
+	level.info->Snapshot.Clean();
+
+	demo_p = demobuffer + kf.DemoPos;
+	DemoTic = kf.Tic;
+}
+
+//==========================================================================
+//
+// Called by G_Ticker during playback before the demo commands for
+// this tic are read, so keyframes are taken at a tic boundary.
+//
+//==========================================================================
+
+static void G_DemoKeyframeTicker()
+{
+	if (DemoSeekRestore)
+	{
+		DemoSeekRestore = false;
+
+		// Use the last keyframe before the target, but only if that is
+		// actually closer than just running forward from here.
+		int best = -1;
+		for (unsigned i = 0; i < DemoKeyframes.Size() && DemoKeyframes[i].Tic <= DemoSeekTarget; i++)
+		{
+			best = i;
+		}
+		if (best >= 0 && (DemoSeekTarget < DemoTic || DemoKeyframes[best].Tic > DemoTic))
+		{
+			G_RestoreDemoKeyframe(DemoKeyframes[best]);
+		}
+		if (DemoSeekTarget <= DemoTic)
+		{
+			G_EndDemoSeek();
+		}
+	}
+
+	int interval = demo_keyframeinterval * TICRATE * DemoKeyframeSpacing;
+	if (interval > 0 && !DemoKeyframesFailed && (DemoKeyframes.Size() == 0 || DemoTic >= DemoKeyframes.Last().Tic + interval))
+	{
+		G_CaptureDemoKeyframe();
+	}
+}
+
+static void G_AdvanceDemoTic()
+{
+	DemoTic++;
+	if (DemoSeekTarget >= 0 && DemoTic >= DemoSeekTarget)
+	{
+		G_EndDemoSeek();
+	}
+}
+
+static void G_DemoSeekTo(int target)
+{
+	if (target == DemoTic)
+	{
+		return;
+	}
+	DemoSeekTarget = target;
+	DemoSeekRestore = true;
+	if (!DemoSeekMuted)
+	{
+		// Sounds started while running forward must not pile up.
+		GSnd->SetSfxPaused(true, 2);
+		DemoSeekMuted = true;
+	}
+}
+
+//==========================================================================
+//
+// demoseek <seconds>   - jump to an absolute position in the demo
+// demoseek +/-<seconds> - jump relative to the current position
+//
+//==========================================================================
+
+CCMD(demoseek)
+{
+	if (!demoplayback)
+	{
+		Printf("Not playing a demo.\n");
+		return;
+	}
+	if (argv.argc() < 2)
+	{
+		Printf("Usage: demoseek [+|-]<seconds>\n");
+		Printf("Current position: %d:%02d, %u keyframes (%u KB)\n", DemoTic / TICRATE / 60, DemoTic / TICRATE % 60,
+			DemoKeyframes.Size(), unsigned(DemoKeyframeBytes >> 10));
+		return;
+	}
+	if (gamestate != GS_LEVEL)
+	{
+		Printf("Can only seek while in a level.\n");
+		return;
+	}
+
+	const char *arg = argv[1];
+	int tics = int(atof(arg) * TICRATE);
+	int target = (arg[0] == '+' || arg[0] == '-') ? DemoTic + tics : tics;
+	G_DemoSeekTo(MAX(target, 0));
+}
+
 void G_StartSlideshow(FName whichone)
 {
 	gameaction = ga_slideshow;
@@ -69,6 +69,7 @@ void G_BeginRecording (const char *startmap);
 void G_PlayDemo (char* name);
 void G_TimeDemo (const char* name);
 bool G_CheckDemoStatus (void);
+bool G_DemoSeeking ();
 
 void G_WorldDone (void);
 
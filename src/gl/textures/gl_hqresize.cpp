@@ -39,6 +39,13 @@
 #include "gl/renderer/gl_renderer.h"
 #include "gl/textures/gl_texture.h"
 #include "c_cvars.h"
+#include "c_dispatch.h"
+#include "md5.h"
+#include "m_misc.h"
+#include "cmdlib.h"
+#include "files.h"
+#include "m_swap.h"
+#include "doomerrors.h"
 #include "gl/hqnx/hqx.h"
 #ifdef HAVE_MMX
 #include "gl/hqnx_asm/hqnx_asm.h"
@@ -47,6 +54,8 @@
 #include "gl/xbr/xbrz_old.h"
 
 #include "parallel_for.h"
+#include <zlib.h>
+#include <algorithm>
 
 EXTERN_CVAR(Int, gl_texture_hqresizemult)
 CUSTOM_CVAR(Int, gl_texture_hqresizemode, 0, CVAR_ARCHIVE | CVAR_GLOBALCONFIG | CVAR_NOINITCALL)
@@ -83,6 +92,8 @@ CVAR (Flag, gl_texture_hqresize_sprites, gl_texture_hqresize_targets, 2);
 CVAR (Flag, gl_texture_hqresize_fonts, gl_texture_hqresize_targets, 4);
 
 CVAR(Bool, gl_texture_hqresize_multithread, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);
+CVAR(Bool, gl_texture_hqresize_diskcache, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);
+CVAR(Int, gl_texture_hqresize_diskcachesize, 256, CVAR_ARCHIVE | CVAR_GLOBALCONFIG);	// in MB, 0 for no limit
 
 CUSTOM_CVAR(Int, gl_texture_hqresize_mt_width, 16, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
 {
@@ -401,6 +412,231 @@ static void xbrzOldScale(size_t factor, const uint32_t* src, uint32_t* trg, int
 }
 
 
+//===========================================================================
+//
+// Disk cache for upsampled textures
+//
+// Each upsampled texture is stored in its own file, named after an MD5
+// hash of the source pixels and all settings that affect the output.
+// Once the directory grows past gl_texture_hqresize_diskcachesize the
+// oldest files are deleted.
+//
+//===========================================================================
+
+static const char UpscaleCacheMagic[4] = { 'H', 'Q', 'R', '1' };
+static const int UpscaleCacheMaxDimension = 8192;	// larger outputs are neither loaded nor saved
+static int64_t UpscaleCacheBytes = -1;				// size of the cache directory, -1 if not known yet
+
+static FString GetUpscaleCachePath(bool create)
+{
+	FString path = M_GetCachePath(create);
+	path << "/hqresize";
+	if (create) CreatePath(path);
+	return path;
+}
+
+static FString CreateUpscaleCacheName(int type, int mult, const unsigned char *inputBuffer, int inWidth, int inHeight)
+{
+	uint32_t header[4] = { LittleLong(uint32_t(type)), LittleLong(uint32_t(mult)), LittleLong(uint32_t(inWidth)), LittleLong(uint32_t(inHeight)) };
+
+	MD5Context md5;
+	md5.Update((const uint8_t *)header, sizeof(header));
+	if (type == 4 || type == 5)
+	{
+		float options[5] = { xbrz_luminanceweight, xbrz_equalcolortolerance, xbrz_centerdirectionbias, xbrz_dominantdirectionthreshold, xbrz_steepdirectionthreshold };
+		md5.Update((const uint8_t *)options, sizeof(options));
+		uint32_t colorformat = LittleLong(uint32_t(xbrz_colorformat));
+		md5.Update((const uint8_t *)&colorformat, sizeof(colorformat));
+	}
+	md5.Update(inputBuffer, inWidth * inHeight * 4);
+
+	uint8_t digest[16];
+	md5.Final(digest);
+
+	FString path = GetUpscaleCachePath(false);
+	path << '/';
+	for (int i = 0; i < 16; i++)
+	{
+		path.AppendFormat("%02x", digest[i]);
+	}
+	path << ".hqc";
+	return path;
+}
+
+static unsigned char *LoadCachedUpscale(const FString &path, int &outWidth, int &outHeight)
+{
+	FileReader fr;
+	char magic[4];
+
+	if (!fr.OpenFile(path)) return nullptr;
+	if (fr.Read(magic, 4) != 4 || memcmp(magic, UpscaleCacheMagic, 4)) return nullptr;
+
+	uint32_t width = fr.ReadUInt32();
+	uint32_t height = fr.ReadUInt32();
+	if (width == 0 || height == 0 || width > UpscaleCacheMaxDimension || height > UpscaleCacheMaxDimension) return nullptr;
+
+	auto compressed = fr.Read(fr.GetLength() - fr.Tell());
+	uLongf size = width * height * 4;
+	unsigned char *buffer = new unsigned char[size];
+	if (uncompress(buffer, &size, compressed.Data(), (uLong)compressed.Size()) != Z_OK || size != width * height * 4)
+	{
+		delete[] buffer;
+		return nullptr;
+	}
+	outWidth = width;
+	outHeight = height;
+	return buffer;
+}
+
+static bool ScanUpscaleCache(TArray<FFileList> &list)
+{
+	FString path = GetUpscaleCachePath(false);
+	path += "/";
+	if (!DirExists(path)) return true;
+
+	try
+	{
+		ScanDirectory(list, path);
+	}
+	catch (CRecoverableError &err)
+	{
+		Printf("%s\n", err.GetMessage());
+		return false;
+	}
+	return true;
+}
+
+static void TrimUpscaleCache(int64_t budget)
+{
+	struct CacheFile
+	{
+		FString Filename;
+		size_t Size;
+		time_t Time;
+	};
+	TArray<FFileList> list;
+	TArray<CacheFile> files;
+
+	if (!ScanUpscaleCache(list)) return;
+
+	UpscaleCacheBytes = 0;
+	for (auto &entry : list)
+	{
+		CacheFile file;
+		if (!entry.isDirectory && GetFileInfo(entry.Filename, &file.Size, &file.Time))
+		{
+			file.Filename = entry.Filename;
+			UpscaleCacheBytes += file.Size;
+			files.Push(file);
+		}
+	}
+	if (budget < 0 || UpscaleCacheBytes <= budget) return;
+
+	// Trim to three quarters of the budget so that this does not have to run again on the next save.
+	std::sort(files.begin(), files.end(), [](const CacheFile &a, const CacheFile &b) { return a.Time < b.Time; });
+	for (auto &file : files)
+	{
+		if (UpscaleCacheBytes <= budget / 4 * 3) break;
+		if (remove(file.Filename) == 0) UpscaleCacheBytes -= file.Size;
+	}
+}
+
+static void SaveCachedUpscale(const FString &path, const unsigned char *buffer, int width, int height)
+{
+	if (width > UpscaleCacheMaxDimension || height > UpscaleCacheMaxDimension) return;
+
+	uLong size = width * height * 4;
+	uLongf outlen = compressBound(size);
+	TArray<Bytef> compressed(outlen + 12, true);
+
+	if (compress2(compressed.Data() + 12, &outlen, buffer, size, Z_BEST_SPEED) != Z_OK) return;
+
+	uint32_t dims[2] = { LittleLong(uint32_t(width)), LittleLong(uint32_t(height)) };
+	memcpy(compressed.Data(), UpscaleCacheMagic, 4);
+	memcpy(compressed.Data() + 4, dims, 8);
+
+	GetUpscaleCachePath(true);
+	FileWriter *fw = FileWriter::Open(path);
+	if (fw != nullptr)
+	{
+		const size_t length = outlen + 12;
+		if (fw->Write(compressed.Data(), length) != length)
+		{
+			Printf("Error saving upscaled texture to %s\n", path.GetChars());
+		}
+		delete fw;
+
+		int64_t budget = int64_t(gl_texture_hqresize_diskcachesize) << 20;
+		if (UpscaleCacheBytes < 0)
+		{
+			TrimUpscaleCache(budget > 0 ? budget : -1);
+		}
+		else
+		{
+			UpscaleCacheBytes += length;
+			if (budget > 0 && UpscaleCacheBytes > budget) TrimUpscaleCache(budget);
+		}
+	}
+}
+
+UNSAFE_CCMD(clearhqresizecache)
+{
+	TArray<FFileList> list;
+
+	if (!ScanUpscaleCache(list)) return;
+	for (auto &entry : list)
+	{
+		if (!entry.isDirectory) remove(entry.Filename);
+	}
+	UpscaleCacheBytes = -1;
+}
+
+static unsigned char *UpscaleBuffer(int type, int mult, unsigned char *inputBuffer, const int inWidth, const int inHeight, int &outWidth, int &outHeight)
+{
+	switch (type)
+	{
+	case 1:
+		switch(mult)
+		{
+		case 2:
+			return scaleNxHelper( &scale2x, 2, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+		case 3:
+			return scaleNxHelper( &scale3x, 3, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+		default:
+			return scaleNxHelper( &scale4x, 4, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+		}
+	case 2:
+		switch(mult)
+		{
+		case 2:
+			return hqNxHelper( &hq2x_32, 2, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+		case 3:
+			return hqNxHelper( &hq3x_32, 3, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+		default:
+			return hqNxHelper( &hq4x_32, 4, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+		}
+#ifdef HAVE_MMX
+	case 3:
+		switch(mult)
+		{
+		case 2:
+			return hqNxAsmHelper( &HQnX_asm::hq2x_32, 2, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+		case 3:
+			return hqNxAsmHelper( &HQnX_asm::hq3x_32, 3, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+		default:
+			return hqNxAsmHelper( &HQnX_asm::hq4x_32, 4, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+		}
+#endif
+	case 4:
+		return xbrzHelper(xbrz::scale, mult, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+	case 5:			
+		return xbrzHelper(xbrzOldScale, mult, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+	case 6:
+		return normalNx(mult, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+	}
+	return inputBuffer;
+}
+
 //===========================================================================
 // 
 // [BB] Upsamples the texture in inputBuffer, frees inputBuffer and returns
@@ -463,47 +699,27 @@ unsigned char *gl_CreateUpsampledTextureBuffer ( const FTexture *inputTexture, u
 		if (mult < 2)
 			type = 0;
 
-		switch (type)
+		if (type == 0)
+			return inputBuffer;
+
+		FString cachename;
+		if (gl_texture_hqresize_diskcache)
 		{
-		case 1:
-			switch(mult)
+			cachename = CreateUpscaleCacheName(type, mult, inputBuffer, inWidth, inHeight);
+			unsigned char *cached = LoadCachedUpscale(cachename, outWidth, outHeight);
+			if (cached != nullptr)
 			{
-			case 2:
-				return scaleNxHelper( &scale2x, 2, inputBuffer, inWidth, inHeight, outWidth, outHeight );
-			case 3:
-				return scaleNxHelper( &scale3x, 3, inputBuffer, inWidth, inHeight, outWidth, outHeight );
-			default:
-				return scaleNxHelper( &scale4x, 4, inputBuffer, inWidth, inHeight, outWidth, outHeight );
+				delete[] inputBuffer;
+				return cached;
 			}
-		case 2:
-			switch(mult)
-			{
-			case 2:
-				return hqNxHelper( &hq2x_32, 2, inputBuffer, inWidth, inHeight, outWidth, outHeight );
-			case 3:
-				return hqNxHelper( &hq3x_32, 3, inputBuffer, inWidth, inHeight, outWidth, outHeight );
-			default:
-				return hqNxHelper( &hq4x_32, 4, inputBuffer, inWidth, inHeight, outWidth, outHeight );
-			}
-#ifdef HAVE_MMX
-		case 3:
-			switch(mult)
-			{
-			case 2:
-				return hqNxAsmHelper( &HQnX_asm::hq2x_32, 2, inputBuffer, inWidth, inHeight, outWidth, outHeight );
-			case 3:
-				return hqNxAsmHelper( &HQnX_asm::hq3x_32, 3, inputBuffer, inWidth, inHeight, outWidth, outHeight );
-			default:
-				return hqNxAsmHelper( &HQnX_asm::hq4x_32, 4, inputBuffer, inWidth, inHeight, outWidth, outHeight );
-			}
-#endif
-		case 4:
-			return xbrzHelper(xbrz::scale, mult, inputBuffer, inWidth, inHeight, outWidth, outHeight );
-		case 5:			
-			return xbrzHelper(xbrzOldScale, mult, inputBuffer, inWidth, inHeight, outWidth, outHeight );
-		case 6:
-			return normalNx(mult, inputBuffer, inWidth, inHeight, outWidth, outHeight );
 		}
+
+		unsigned char *outputBuffer = UpscaleBuffer(type, mult, inputBuffer, inWidth, inHeight, outWidth, outHeight);
+		if (cachename.IsNotEmpty() && outputBuffer != inputBuffer)
+		{
+			SaveCachedUpscale(cachename, outputBuffer, outWidth, outHeight);
+		}
+		return outputBuffer;
 	}
 	return inputBuffer;
 }
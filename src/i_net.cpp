@@ -192,6 +192,57 @@ int FindNode (const sockaddr_in *address)
 	return i;
 }
 
+//
+// Packets are compressed as raw deflate streams. The zlib header and
+// Adler-32 trailer would add six bytes to every packet, which matters
+// for the small per-tic packets, and UDP already checksums the data.
+// The streams are kept around so that their state does not need to be
+// allocated again for every packet.
+//
+static z_stream PacketDeflate, PacketInflate;
+static bool PacketStreamsInited;
+
+static void InitPacketStreams ()
+{
+	if (!PacketStreamsInited)
+	{
+		memset(&PacketDeflate, 0, sizeof(PacketDeflate));
+		memset(&PacketInflate, 0, sizeof(PacketInflate));
+		if (deflateInit2(&PacketDeflate, 9, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK ||
+			inflateInit2(&PacketInflate, -15) != Z_OK)
+		{
+			I_FatalError("Could not initialize net compression");
+		}
+		PacketStreamsInited = true;
+	}
+}
+
+static int CompressPacket (uint8_t *dest, uLong *destlen, const uint8_t *src, uLong srclen)
+{
+	InitPacketStreams();
+	deflateReset(&PacketDeflate);
+	PacketDeflate.next_in = (Bytef *)src;
+	PacketDeflate.avail_in = srclen;
+	PacketDeflate.next_out = dest;
+	PacketDeflate.avail_out = *destlen;
+	int err = deflate(&PacketDeflate, Z_FINISH);
+	*destlen = PacketDeflate.total_out;
+	return err == Z_STREAM_END ? Z_OK : err == Z_OK ? Z_BUF_ERROR : err;
+}
+
+static int UncompressPacket (uint8_t *dest, uLong *destlen, const uint8_t *src, uLong srclen)
+{
+	InitPacketStreams();
+	inflateReset(&PacketInflate);
+	PacketInflate.next_in = (Bytef *)src;
+	PacketInflate.avail_in = srclen;
+	PacketInflate.next_out = dest;
+	PacketInflate.avail_out = *destlen;
+	int err = inflate(&PacketInflate, Z_FINISH);
+	*destlen = PacketInflate.total_out;
+	return err == Z_STREAM_END ? Z_OK : err == Z_OK ? Z_BUF_ERROR : err;
+}
+
 //
 // PacketSend
 //
@@ -212,7 +263,7 @@ void PacketSend (void)
 	if (doomcom.datalength >= 10)
 	{
 		TransmitBuffer[0] = doomcom.data[0] | NCMD_COMPRESSED;
-		c = compress2(TransmitBuffer + 1, &size, doomcom.data + 1, doomcom.datalength - 1, 9);
+		c = CompressPacket(TransmitBuffer + 1, &size, doomcom.data + 1, doomcom.datalength - 1);
 		size += 1;
 	}
 	else
@@ -297,7 +348,7 @@ void PacketGet (void)
 		if (TransmitBuffer[0] & NCMD_COMPRESSED)
 		{
 			uLongf msgsize = MAX_MSGLEN - 1;
-			int err = uncompress(doomcom.data + 1, &msgsize, TransmitBuffer + 1, c - 1);
+			int err = UncompressPacket(doomcom.data + 1, &msgsize, TransmitBuffer + 1, c - 1);
 //			Printf("recv %d/%lu\n", c, msgsize + 1);
 			if (err != Z_OK)
 			{
@@ -955,8 +955,7 @@ void ACSStringPool::PoolEntry::Unlock()
 
 ACSStringPool::ACSStringPool()
 {
-	memset(PoolBuckets, 0xFF, sizeof(PoolBuckets));
-	FirstFreeEntry = 0;
+	Clear();
 }
 
 //============================================================================
@@ -970,8 +969,11 @@ ACSStringPool::ACSStringPool()
 void ACSStringPool::Clear()
 {
 	Pool.Clear();
-	memset(PoolBuckets, 0xFF, sizeof(PoolBuckets));
-	FirstFreeEntry = 0;
+	FreeEntries.Clear();
+	PoolBuckets.Resize(MIN_BUCKETS);
+	memset(&PoolBuckets[0], 0xFF, MIN_BUCKETS * sizeof(PoolBuckets[0]));
+	UsedCount = 0;
+	GCThreshold = MIN_GC_SIZE;
 }
 
 //============================================================================
@@ -988,26 +990,24 @@ int ACSStringPool::AddString(const char *str)
 	if (str == nullptr) str = "";
 	size_t len = strlen(str);
 	unsigned int h = SuperFastHash(str, len);
-	unsigned int bucketnum = h % NUM_BUCKETS;
-	int i = FindString(str, len, h, bucketnum);
+	int i = FindString(str, len, h);
 	if (i >= 0)
 	{
 		return i | STRPOOL_LIBRARYID_OR;
 	}
 	FString fstr(str);
-	return InsertString(fstr, h, bucketnum);
+	return InsertString(fstr, h);
 }
 
 int ACSStringPool::AddString(FString &str)
 {
 	unsigned int h = SuperFastHash(str.GetChars(), str.Len());
-	unsigned int bucketnum = h % NUM_BUCKETS;
-	int i = FindString(str, str.Len(), h, bucketnum);
+	int i = FindString(str, str.Len(), h);
 	if (i >= 0)
 	{
 		return i | STRPOOL_LIBRARYID_OR;
 	}
-	return InsertString(str, h, bucketnum);
+	return InsertString(str, h);
 }
 
 //============================================================================
@@ -1209,8 +1209,9 @@ void ACSStringPool::PurgeStrings()
 {
 	// Clear the hash buckets. We'll rebuild them as we decide what strings
 	// to keep and which to toss.
-	memset(PoolBuckets, 0xFF, sizeof(PoolBuckets));
-	size_t usedcount = 0, freedcount = 0;
+	memset(&PoolBuckets[0], 0xFF, PoolBuckets.Size() * sizeof(PoolBuckets[0]));
+	unsigned int mask = PoolBuckets.Size() - 1;
+	UsedCount = 0;
 	for (unsigned int i = 0; i < Pool.Size(); ++i)
 	{
 		PoolEntry *entry = &Pool[i];
@@ -1218,21 +1219,16 @@ void ACSStringPool::PurgeStrings()
 		{
 			if (entry->Locks.Size() == 0 && !entry->Mark)
 			{
-				freedcount++;
 				// Mark this entry as free.
 				entry->Next = FREE_ENTRY;
-				if (i < FirstFreeEntry)
-				{
-					FirstFreeEntry = i;
-				}
 				// And free the string.
 				entry->Str = "";
 			}
 			else
 			{
-				usedcount++;
+				UsedCount++;
 				// Rehash this entry.
-				unsigned int h = entry->Hash % NUM_BUCKETS;
+				unsigned int h = entry->Hash & mask;
 				entry->Next = PoolBuckets[h];
 				PoolBuckets[h] = i;
 				// Remove MarkString's mark.
@@ -1240,6 +1236,12 @@ void ACSStringPool::PurgeStrings()
 			}
 		}
 	}
+	RebuildFreeList();
+
+	// Let the pool grow to twice the strings that survived before collecting
+	// again. With a fixed limit, a pool that is mostly live would be collected
+	// over and over again for every few new strings.
+	GCThreshold = MAX<unsigned int>(MIN_GC_SIZE, UsedCount * 2);
 }
 
 //============================================================================
@@ -1251,9 +1253,9 @@ void ACSStringPool::PurgeStrings()
 //
 //============================================================================
 
-int ACSStringPool::FindString(const char *str, size_t len, unsigned int h, unsigned int bucketnum)
+int ACSStringPool::FindString(const char *str, size_t len, unsigned int h)
 {
-	unsigned int i = PoolBuckets[bucketnum];
+	unsigned int i = PoolBuckets[h & (PoolBuckets.Size() - 1)];
 	while (i != NO_ENTRY)
 	{
 		PoolEntry *entry = &Pool[i];
@@ -1276,27 +1278,33 @@ int ACSStringPool::FindString(const char *str, size_t len, unsigned int h, unsig
 //
 //============================================================================
 
-int ACSStringPool::InsertString(FString &str, unsigned int h, unsigned int bucketnum)
+int ACSStringPool::InsertString(FString &str, unsigned int h)
 {
-	unsigned int index = FirstFreeEntry;
-	if (index >= MIN_GC_SIZE && index == Pool.Max())
-	{ // We will need to grow the array. Try a garbage collection first.
+	if (UsedCount >= GCThreshold)
+	{ // Try a garbage collection first.
 		P_CollectACSGlobalStrings();
-		index = FirstFreeEntry;
 	}
-	if (FirstFreeEntry >= STRPOOL_LIBRARYID_OR)
-	{ // If we go any higher, we'll collide with the library ID marker.
-		return -1;
+	unsigned int index;
+	if (FreeEntries.Size() > 0)
+	{
+		index = FreeEntries.Last();
 	}
-	if (index == Pool.Size())
+	else
 	{ // There were no free entries; make a new one.
-		Pool.Reserve(MIN_GC_SIZE);
-		FirstFreeEntry++;
+		index = Pool.Size();
+		if (index >= STRPOOL_LIBRARYID_OR)
+		{ // If we go any higher, we'll collide with the library ID marker.
+			return -1;
+		}
+		Pool.Reserve(1);
+		FreeEntries.Push(index);
 	}
-	else
-	{ // Scan for the next free entry
-		FindFirstFreeEntry(FirstFreeEntry + 1);
+	FreeEntries.Pop();
+	if (++UsedCount > PoolBuckets.Size())
+	{
+		Rehash(PoolBuckets.Size() * 2);
 	}
+	unsigned int bucketnum = h & (PoolBuckets.Size() - 1);
 	PoolEntry *entry = &Pool[index];
 	entry->Str = str;
 	entry->Hash = h;
@@ -1309,19 +1317,47 @@ int ACSStringPool::InsertString(FString &str, unsigned int h, unsigned int bucke
 
 //============================================================================
 //
-// ACSStringPool :: FindFirstFreeEntry
+// ACSStringPool :: Rehash
 //
-// Finds the first free entry, starting at base.
+// Changes the number of hash buckets and links all strings into them again.
 //
 //============================================================================
 
-void ACSStringPool::FindFirstFreeEntry(unsigned base)
+void ACSStringPool::Rehash(unsigned int numbuckets)
 {
-	while (base < Pool.Size() && Pool[base].Next != FREE_ENTRY)
+	PoolBuckets.Resize(numbuckets);
+	memset(&PoolBuckets[0], 0xFF, numbuckets * sizeof(PoolBuckets[0]));
+	for (unsigned int i = 0; i < Pool.Size(); ++i)
 	{
-		base++;
+		PoolEntry *entry = &Pool[i];
+		if (entry->Next != FREE_ENTRY)
+		{
+			unsigned int h = entry->Hash & (numbuckets - 1);
+			entry->Next = PoolBuckets[h];
+			PoolBuckets[h] = i;
+		}
+	}
+}
+
+//============================================================================
+//
+// ACSStringPool :: RebuildFreeList
+//
+// Collects all free entries so that InsertString does not need to search
+// for one. The lowest ones are handed out first.
+//
+//============================================================================
+
+void ACSStringPool::RebuildFreeList()
+{
+	FreeEntries.Clear();
+	for (unsigned int i = Pool.Size(); i-- > 0; )
+	{
+		if (Pool[i].Next == FREE_ENTRY)
+		{
+			FreeEntries.Push(i);
+		}
 	}
-	FirstFreeEntry = base;
 }
 
 //============================================================================
@@ -1362,11 +1398,9 @@ void ACSStringPool::ReadStrings(FSerializer &file, const char *key)
 						file("string", Pool[ii].Str)
 							("locks", Pool[ii].Locks);
 
-						unsigned h = SuperFastHash(Pool[ii].Str, Pool[ii].Str.Len());
-						unsigned bucketnum = h % NUM_BUCKETS;
-						Pool[ii].Hash = h;
-						Pool[ii].Next = PoolBuckets[bucketnum];
-						PoolBuckets[bucketnum] = ii;
+						Pool[ii].Hash = SuperFastHash(Pool[ii].Str, Pool[ii].Str.Len());
+						Pool[ii].Next = NO_ENTRY;	// linked by Rehash below
+						UsedCount++;
 					}
 					file.EndObject();
 				}
@@ -1374,7 +1408,11 @@ void ACSStringPool::ReadStrings(FSerializer &file, const char *key)
 		}
 	}
 
-	FindFirstFreeEntry(FirstFreeEntry);
+	unsigned int numbuckets = MIN_BUCKETS;
+	while (numbuckets < UsedCount) numbuckets *= 2;
+	Rehash(numbuckets);
+	RebuildFreeList();
+	GCThreshold = MAX<unsigned int>(MIN_GC_SIZE, UsedCount * 2);
 }
 
 //============================================================================
@@ -1435,7 +1473,7 @@ void ACSStringPool::Dump() const
 			Printf("%4u. (%2d) \"%s\"\n", i, Pool[i].Locks.Size(), Pool[i].Str.GetChars());
 		}
 	}
-	Printf("First free %u\n", FirstFreeEntry);
+	Printf("%u used, %u free, %u buckets\n", UsedCount, FreeEntries.Size(), PoolBuckets.Size());
 }
 
 
@@ -6880,6 +6918,271 @@ static bool CharArrayParms(int &capacity, int &offset, int &a, FACSStackMemory&
 	return true;
 }
 
+//==========================================================================
+//
+// RunSimplePCodes
+//
+// Executes a run of p-codes that only move values between the stack,
+// the script's variables and map variables, or branch within the script.
+// None of them can change the script's state, so it is safe to run them
+// outside the main switch in RunScript. As soon as another p-code is
+// encountered, pc is returned pointing at it so RunScript can execute it.
+//
+// This is where scripts spend most of their time in loops. The loop is
+// kept small so that the compiler can keep pc and sp in registers, which
+// it cannot do in RunScript's huge switch.
+//
+//==========================================================================
+
+static int *RunSimplePCodes(int *pc, ACSFormat fmt, FBehavior *module, ACSLocalVariables &locals,
+	ACSLocalArrays *localarrays, FACSStackMemory &Stack, int &stackptr, unsigned int &runaway)
+{
+	int sp = stackptr;
+	unsigned int count = runaway;
+	int *oppc;
+	int pcd;
+
+	// Leave the last step before the runaway limit to RunScript so it gets reported there.
+	for (; count < 2000000; count++)
+	{
+		oppc = pc;
+		if (fmt == ACS_LittleEnhanced)
+		{
+			pcd = getbyte(pc);
+			if (pcd >= 256-16)
+			{
+				pcd = (256-16) + ((pcd - (256-16)) << 8) + getbyte(pc);
+			}
+		}
+		else
+		{
+			pcd = NEXTWORD;
+		}
+
+		switch (pcd)
+		{
+		default:
+			pc = oppc;
+			goto done;
+
+		case PCD_NOP:
+			break;
+
+		case PCD_PUSHNUMBER:
+			PushToStack (uallong(pc[0]));
+			pc++;
+			break;
+
+		case PCD_PUSHBYTE:
+			PushToStack (*(uint8_t *)pc);
+			pc = (int *)((uint8_t *)pc + 1);
+			break;
+
+		case PCD_PUSH2BYTES:
+			Stack[sp] = ((uint8_t *)pc)[0];
+			Stack[sp+1] = ((uint8_t *)pc)[1];
+			sp += 2;
+			pc = (int *)((uint8_t *)pc + 2);
+			break;
+
+		case PCD_DUP:
+			Stack[sp] = Stack[sp-1];
+			sp++;
+			break;
+
+		case PCD_SWAP:
+			swapvalues(Stack[sp-2], Stack[sp-1]);
+			break;
+
+		case PCD_DROP:
+			sp--;
+			break;
+
+		case PCD_ADD:
+			STACK(2) = STACK(2) + STACK(1);
+			sp--;
+			break;
+
+		case PCD_SUBTRACT:
+			STACK(2) = STACK(2) - STACK(1);
+			sp--;
+			break;
+
+		case PCD_MULTIPLY:
+			STACK(2) = STACK(2) * STACK(1);
+			sp--;
+			break;
+
+		case PCD_EQ:
+			STACK(2) = (STACK(2) == STACK(1));
+			sp--;
+			break;
+
+		case PCD_NE:
+			STACK(2) = (STACK(2) != STACK(1));
+			sp--;
+			break;
+
+		case PCD_LT:
+			STACK(2) = (STACK(2) < STACK(1));
+			sp--;
+			break;
+
+		case PCD_GT:
+			STACK(2) = (STACK(2) > STACK(1));
+			sp--;
+			break;
+
+		case PCD_LE:
+			STACK(2) = (STACK(2) <= STACK(1));
+			sp--;
+			break;
+
+		case PCD_GE:
+			STACK(2) = (STACK(2) >= STACK(1));
+			sp--;
+			break;
+
+		case PCD_ANDLOGICAL:
+			STACK(2) = (STACK(2) && STACK(1));
+			sp--;
+			break;
+
+		case PCD_ORLOGICAL:
+			STACK(2) = (STACK(2) || STACK(1));
+			sp--;
+			break;
+
+		case PCD_ANDBITWISE:
+			STACK(2) = (STACK(2) & STACK(1));
+			sp--;
+			break;
+
+		case PCD_ORBITWISE:
+			STACK(2) = (STACK(2) | STACK(1));
+			sp--;
+			break;
+
+		case PCD_EORBITWISE:
+			STACK(2) = (STACK(2) ^ STACK(1));
+			sp--;
+			break;
+
+		case PCD_LSHIFT:
+			STACK(2) = (STACK(2) << STACK(1));
+			sp--;
+			break;
+
+		case PCD_RSHIFT:
+			STACK(2) = (STACK(2) >> STACK(1));
+			sp--;
+			break;
+
+		case PCD_NEGATELOGICAL:
+			STACK(1) = !STACK(1);
+			break;
+
+		case PCD_NEGATEBINARY:
+			STACK(1) = ~STACK(1);
+			break;
+
+		case PCD_UNARYMINUS:
+			STACK(1) = -STACK(1);
+			break;
+
+		case PCD_PUSHSCRIPTVAR:
+			PushToStack (locals[NEXTBYTE]);
+			break;
+
+		case PCD_ASSIGNSCRIPTVAR:
+			locals[NEXTBYTE] = STACK(1);
+			sp--;
+			break;
+
+		case PCD_ADDSCRIPTVAR:
+			locals[NEXTBYTE] += STACK(1);
+			sp--;
+			break;
+
+		case PCD_SUBSCRIPTVAR:
+			locals[NEXTBYTE] -= STACK(1);
+			sp--;
+			break;
+
+		case PCD_INCSCRIPTVAR:
+			++locals[NEXTBYTE];
+			break;
+
+		case PCD_DECSCRIPTVAR:
+			--locals[NEXTBYTE];
+			break;
+
+		case PCD_PUSHMAPVAR:
+			PushToStack (*(module->MapVars[NEXTBYTE]));
+			break;
+
+		case PCD_ASSIGNMAPVAR:
+			*(module->MapVars[NEXTBYTE]) = STACK(1);
+			sp--;
+			break;
+
+		case PCD_PUSHSCRIPTARRAY:
+			STACK(1) = localarrays->Get(locals, NEXTBYTE, STACK(1));
+			break;
+
+		case PCD_ASSIGNSCRIPTARRAY:
+			localarrays->Set(locals, NEXTBYTE, STACK(2), STACK(1));
+			sp -= 2;
+			break;
+
+		case PCD_PUSHMAPARRAY:
+			STACK(1) = module->GetArrayVal (*(module->MapVars[NEXTBYTE]), STACK(1));
+			break;
+
+		case PCD_ASSIGNMAPARRAY:
+			module->SetArrayVal (*(module->MapVars[NEXTBYTE]), STACK(2), STACK(1));
+			sp -= 2;
+			break;
+
+		case PCD_GOTO:
+			pc = module->Ofs2PC (LittleLong(*pc));
+			break;
+
+		case PCD_IFGOTO:
+			if (STACK(1))
+				pc = module->Ofs2PC (LittleLong(*pc));
+			else
+				pc++;
+			sp--;
+			break;
+
+		case PCD_IFNOTGOTO:
+			if (!STACK(1))
+				pc = module->Ofs2PC (LittleLong(*pc));
+			else
+				pc++;
+			sp--;
+			break;
+
+		case PCD_CASEGOTO:
+			if (STACK(1) == uallong(pc[0]))
+			{
+				pc = module->Ofs2PC (uallong(pc[1]));
+				sp--;
+			}
+			else
+			{
+				pc += 2;
+			}
+			break;
+		}
+	}
+done:
+	stackptr = sp;
+	runaway = count;
+	return pc;
+}
+
 int DLevelScript::RunScript ()
 {
 	DACSThinker *controller = DACSThinker::ActiveThinker;
@@ -6972,6 +7275,8 @@ int DLevelScript::RunScript ()
 
 	while (state == SCRIPT_Running)
 	{
+		pc = RunSimplePCodes(pc, fmt, activeBehavior, locals, localarrays, Stack, sp, runaway);
+
 		if (++runaway > 2000000)
 		{
 			Printf ("Runaway %s terminated\n", ScriptPresentation(script).GetChars());
@@ -9062,6 +9367,7 @@ scriptwait:
 						break;
 					}
 				}
+				P_InvalidateSightCache();
 
 				sp -= 2;
 			}
@@ -118,11 +118,12 @@ public:
 	void WriteStrings(FSerializer &file, const char *key) const;
 
 private:
-	int FindString(const char *str, size_t len, unsigned int h, unsigned int bucketnum);
-	int InsertString(FString &str, unsigned int h, unsigned int bucketnum);
-	void FindFirstFreeEntry(unsigned int base);
+	int FindString(const char *str, size_t len, unsigned int h);
+	int InsertString(FString &str, unsigned int h);
+	void Rehash(unsigned int numbuckets);
+	void RebuildFreeList();
 
-	enum { NUM_BUCKETS = 251 };
+	enum { MIN_BUCKETS = 256 };			// Must be a power of 2
 	enum { FREE_ENTRY = 0xFFFFFFFE };	// Stored in PoolEntry's Next field
 	enum { NO_ENTRY = 0xFFFFFFFF };
 	enum { MIN_GC_SIZE = 100 };			// Don't auto-collect until there are this many strings
@@ -138,8 +139,10 @@ private:
 		void Unlock();
 	};
 	TArray<PoolEntry> Pool;
-	unsigned int PoolBuckets[NUM_BUCKETS];
-	unsigned int FirstFreeEntry;
+	TArray<unsigned int> PoolBuckets;	// grows with the pool so the chains stay short
+	TArray<unsigned int> FreeEntries;	// lowest index last
+	unsigned int UsedCount;
+	unsigned int GCThreshold;			// collect when this many strings are in use
 };
 extern ACSStringPool GlobalACSStrings;
 
@@ -3808,14 +3808,15 @@ DEFINE_ACTION_FUNCTION(AActor, A_RadiusGive)
 	}
 	else
 	{
-		FPortalGroupArray check(FPortalGroupArray::PGA_Full3d);
-		double mid = self->Center();
-		FMultiBlockThingsIterator it(check, self->X(), self->Y(), mid-distance, mid+distance, distance, false, self->Sector);
-		FMultiBlockThingsIterator::CheckResult cres;
+		// This only pre-filters the candidates, DoRadiusGive does the exact check.
+		// A cube's corners are further away than its sides.
+		TArray<FRadiusThing> things;
+		double range = (flags & RGF_CUBE) ? distance * g_sqrt(2.) : distance;
+		P_GetThingsInRadius(things, self->Pos(), range + EQUAL_EPSILON, self->Sector, (flags & RGF_CUBE) ? 0 : RTF_SPHERE);
 
-		while ((it.Next(&cres)) && ((unlimited) || (given < limit)))
+		for (unsigned i = 0; i < things.Size() && ((unlimited) || (given < limit)); i++)
 		{
-			given += DoRadiusGive(self, cres.thing, item, amount, distance, flags, filter, species, mindist);
+			given += DoRadiusGive(self, things[i].thing, item, amount, distance, flags, filter, species, mindist);
 		}
 	}
 	ACTION_RETURN_INT(given);
@@ -106,6 +106,20 @@ void DCeiling::PlayCeilingSound ()
 	}
 }
 
+//============================================================================
+//
+// DCeiling :: Predict
+//
+//============================================================================
+
+void DCeiling::Predict ()
+{
+	if (m_Direction == 1)
+		PredictPlane(sector_t::ceiling, m_Speed, m_TopHeight, 1);
+	else if (m_Direction == -1)
+		PredictPlane(sector_t::ceiling, m_Speed, m_BottomHeight, -1);
+}
+
 //============================================================================
 //
 // DCeiling :: Tick
@@ -70,6 +70,20 @@ void DDoor::Serialize(FSerializer &arc)
 		("lighttag", m_LightTag);
 }
 
+//============================================================================
+//
+// DDoor :: Predict
+//
+//============================================================================
+
+void DDoor::Predict ()
+{
+	if (m_Direction == 1)
+		PredictPlane(sector_t::ceiling, m_Speed, m_TopDist, 1);
+	else if (m_Direction == -1)
+		PredictPlane(sector_t::ceiling, m_Speed, m_BotDist, -1);
+}
+
 //============================================================================
 //
 // T_VerticalDoor
@@ -97,6 +97,21 @@ void DFloor::Serialize(FSerializer &arc)
 		("instant", m_Instant);
 }
 
+//==========================================================================
+//
+// Prediction only follows the current move; stair pauses and
+// resets are left to the real thinker.
+//
+//==========================================================================
+
+void DFloor::Predict ()
+{
+	if (m_Type == waitStair || m_PauseTime != 0)
+		return;
+
+	PredictPlane(sector_t::floor, m_Speed, m_FloorDestDist, m_Direction);
+}
+
 //==========================================================================
 //
 // MOVE A FLOOR TO ITS DESTINATION (UP OR DOWN)
@@ -910,6 +925,18 @@ void DElevator::OnDestroy()
 	Super::OnDestroy();
 }
 
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+void DElevator::Predict ()
+{
+	PredictPlane(sector_t::floor, m_Speed, m_FloorDestDist, m_Direction);
+	PredictPlane(sector_t::ceiling, m_Speed, m_CeilingDestDist, m_Direction);
+}
+
 //==========================================================================
 //
 // T_MoveElevator()
@@ -1016,20 +1016,25 @@ bool P_CheckNodes(MapData * map, bool rebuilt, int buildtime)
 typedef TArray<uint8_t> MemFile;
 
 
-static FString CreateCacheName(MapData *map, bool create)
+FString P_GetMapCacheName(int maplump, bool create, const char *extension)
 {
 	FString path = M_GetCachePath(create);
-	FString lumpname = Wads.GetLumpFullPath(map->lumpnum);
+	FString lumpname = Wads.GetLumpFullPath(maplump);
 	int separator = lumpname.IndexOf(':');
 	path << '/' << lumpname.Left(separator);
 	if (create) CreatePath(path);
 
 	lumpname.ReplaceChars('/', '%');
 	lumpname.ReplaceChars(':', '$');
-	path << '/' << lumpname.Right(lumpname.Len() - separator - 1) << ".gzc";
+	path << '/' << lumpname.Right(lumpname.Len() - separator - 1) << '.' << extension;
 	return path;
 }
 
+static FString CreateCacheName(MapData *map, bool create)
+{
+	return P_GetMapCacheName(map->lumpnum, create, "gzc");
+}
+
 static void WriteByte(MemFile &f, uint8_t b)
 {
 	f.Push(b);
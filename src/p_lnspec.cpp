@@ -3951,6 +3951,8 @@ int P_ExecuteSpecial(int			num,
 {
 	if (num >= 0 && num < (int)countof(LineSpecials))
 	{
+		// Many specials change lines or sectors in ways that affect sight.
+		P_InvalidateSightCache();
 		return LineSpecials[num](line, activator, backSide, arg1, arg2, arg3, arg4, arg5);
 	}
 	return 0;
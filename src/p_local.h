@@ -46,6 +46,7 @@ struct line_t;
 struct sector_t;
 struct msecnode_t;
 struct portnode_t;
+struct FSecNodeCache;
 struct secplane_t;
 struct FCheckPosition;
 struct FTranslatedLineTarget;
@@ -292,6 +293,7 @@ enum ESightFlags
 };
 
 void	P_ResetSightCounters (bool full);
+void	P_InvalidateSightCache ();
 bool	P_TalkFacing (AActor *player);
 void	P_UseLines (player_t* player);
 int	P_UsePuzzleItem (AActor *actor, int itemType);
@@ -429,7 +431,7 @@ nodetype *P_AddSecnode(linktype *s, AActor *thing, nodetype *nextnode, nodetype
 template<class nodetype, class linktype>
 nodetype* P_DelSecnode(nodetype *, nodetype *linktype::*head);
 
-msecnode_t *P_CreateSecNodeList(AActor *thing, double radius, msecnode_t *sector_list, msecnode_t *sector_t::*seclisthead);
+msecnode_t *P_CreateSecNodeList(AActor *thing, double radius, msecnode_t *sector_list, msecnode_t *sector_t::*seclisthead, FSecNodeCache *cache = nullptr);
 double	P_GetMoveFactor(const AActor *mo, double *frictionp);	// phares  3/6/98
 double		P_GetFriction(const AActor *mo, double *frictionfactor);
 
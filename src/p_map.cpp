@@ -105,6 +105,11 @@
 CVAR(Bool, cl_bloodsplats, true, CVAR_ARCHIVE)
 CVAR(Int, sv_smartaim, 0, CVAR_ARCHIVE | CVAR_SERVERINFO)
 CVAR(Bool, cl_doautoaim, false, CVAR_ARCHIVE)
+// Lets P_ChangeSector skip things a moving plane cannot reach. This is not
+// the same as the full check: skipped things get no pickups, touchy or bump
+// specials, skull slams and so on from it, so it stays off by default and
+// old demos always play back without it.
+CVAR(Bool, sv_fastchangesector, false, CVAR_ARCHIVE | CVAR_SERVERINFO)
 
 static void CheckForPushSpecial(line_t *line, int side, AActor *mobj, DVector2 * posforwindowcheck = NULL);
 static void SpawnShootDecal(AActor *t1, AActor *defaults, const FTraceResults &trace);
@@ -6066,6 +6071,9 @@ struct FChangePosition
 	bool nofit;
 	bool movemidtex;
 	bool instant;
+	bool checkband;		// the moved plane is flat and can only affect things through its height
+	double bandbottom;	// range that contains every height the plane had during the move
+	double bandtop;
 };
 
 TArray<AActor *> intersectors;
@@ -6643,6 +6651,42 @@ void PIT_CeilingRaise(AActor *thing, FChangePosition *cpos)
 	}
 }
 
+//=============================================================================
+//
+// P_PlaneMoveMissesThing
+//
+// Returns true if the plane stayed clear of every height the thing took its
+// floorz, dropoffz or ceilingz from, both before and after the move. In that
+// case P_AdjustFloorCeil would come up with the same values again, so the
+// costly position check can be skipped. That check can still have side
+// effects on things it touches, which is why this needs sv_fastchangesector.
+//
+//=============================================================================
+
+static bool P_PlaneMoveMissesThing(AActor *thing, FChangePosition *cpos, void(*iterator)(AActor *, FChangePosition *))
+{
+	if (!sv_fastchangesector || !cpos->checkband || (thing->flags4 & MF4_ACTLIKEBRIDGE))
+	{
+		return false;
+	}
+	if (iterator == PIT_FloorDrop || iterator == PIT_FloorRaise)
+	{
+		// Both iterators leave the thing alone if its floorz does not change.
+		return cpos->bandtop < thing->floorz && cpos->bandbottom > thing->dropoffz;
+	}
+	if (cpos->bandbottom <= thing->ceilingz)
+	{
+		return false;
+	}
+	if (iterator == PIT_CeilingLower)
+	{
+		return thing->Top() <= thing->ceilingz;
+	}
+	// PIT_CeilingRaise can also move things that are stuck in the floor or
+	// on top of other actors, regardless of what happened to the ceiling.
+	return thing->Z() >= thing->floorz && !(thing->flags2 & MF2_PASSMOBJ);
+}
+
 //=============================================================================
 //
 // P_ChangeSector	[RH] Was P_CheckSector in BOOM
@@ -6660,12 +6704,15 @@ bool P_ChangeSector(sector_t *sector, int crunch, double amt, int floorOrCeil, b
 	void(*iterator2)(AActor *, FChangePosition *) = NULL;
 	msecnode_t *n;
 
+	P_InvalidateSightCache();
+
 	cpos.nofit = false;
 	cpos.crushchange = crunch;
 	cpos.moveamt = fabs(amt);
 	cpos.movemidtex = false;
 	cpos.sector = sector;
 	cpos.instant = instant;
+	cpos.checkband = false;
 
 	// Also process all sectors that have 3D floors transferred from the
 	// changed sector.
@@ -6744,6 +6791,22 @@ bool P_ChangeSector(sector_t *sector, int crunch, double amt, int floorOrCeil, b
 		return false;
 	}
 
+	// Things that only touch the sector at heights the plane did not pass
+	// through do not need to be checked again. This does not work if the
+	// plane is sloped, leads through a portal or can be seen through
+	// 3D floors or height transfers, so those always check everything.
+	// Not all callers pass amt with the sign of the actual move (waggling
+	// planes and the pastdest ceiling restore don't), so the band covers
+	// the distance in both directions.
+	if (floorOrCeil != 2 && sector->heightsec == nullptr && sector->e->XFloor.ffloors.Size() == 0 &&
+		!sector->PortalIsLinked(floorOrCeil) && !sector->GetSecPlane(floorOrCeil).isSlope())
+	{
+		double planez = sector->GetSecPlane(floorOrCeil).ZatPoint(sector->centerspot);
+		cpos.checkband = true;
+		cpos.bandbottom = planez - cpos.moveamt - EQUAL_EPSILON;
+		cpos.bandtop = planez + cpos.moveamt + EQUAL_EPSILON;
+	}
+
 	// killough 4/4/98: scan list front-to-back until empty or exhausted,
 	// restarting from beginning after each thing is processed. Avoids
 	// crashes, and is sure to examine all things in the sector, and only
@@ -6764,8 +6827,9 @@ bool P_ChangeSector(sector_t *sector, int crunch, double amt, int floorOrCeil, b
 			if (!n->visited)								// unprocessed thing found
 			{
 				n->visited = true; 							// mark thing as processed
-				if (!(n->m_thing->flags & MF_NOBLOCKMAP) ||	//jff 4/7/98 don't do these
-					(n->m_thing->flags5 & MF5_MOVEWITHSECTOR))
+				if ((!(n->m_thing->flags & MF_NOBLOCKMAP) ||	//jff 4/7/98 don't do these
+					(n->m_thing->flags5 & MF5_MOVEWITHSECTOR)) &&
+					!P_PlaneMoveMissesThing(n->m_thing, &cpos, iterator))
 				{
 					iterator(n->m_thing, &cpos);		 			// process it
 					if (iterator2 != NULL) iterator2(n->m_thing, &cpos);
@@ -61,6 +61,7 @@
 
 
 #include <stdlib.h>
+#include <algorithm>
 
 
 #include "m_bbox.h"
@@ -497,8 +498,8 @@ void AActor::LinkToWorld(FLinkContext *ctx, bool spawningmapthing, sector_t *sec
 		// When a node is deleted, its sector links (the links starting
 		// at sector_t->touching_thinglist) are broken. When a node is
 		// added, new sector links are created.
-		touching_sectorlist = P_CreateSecNodeList(this, radius, ctx != nullptr? ctx->sector_list : nullptr, &sector_t::touching_thinglist);	// Attach to thing
-		if (renderradius >= 0) touching_rendersectors = P_CreateSecNodeList(this, RenderRadius(), ctx != nullptr ? ctx->render_list : nullptr, &sector_t::touching_renderthings);
+		touching_sectorlist = P_CreateSecNodeList(this, radius, ctx != nullptr? ctx->sector_list : nullptr, &sector_t::touching_thinglist, &sectorlistcache);	// Attach to thing
+		if (renderradius >= 0) touching_rendersectors = P_CreateSecNodeList(this, RenderRadius(), ctx != nullptr ? ctx->render_list : nullptr, &sector_t::touching_renderthings, &rendersectorcache);
 		else
 		{
 			touching_rendersectors = nullptr;
@@ -1189,6 +1190,79 @@ void FMultiBlockThingsIterator::Reset()
 	startIteratorForGroup(basegroup);
 }
 
+//===========================================================================
+//
+// P_GetThingsInRadius
+//
+// Collects all things within the given distance of pos, including those
+// behind linked portals. Unlike the block iterators this returns every
+// thing only once, even if it can be reached through more than one portal
+// group. Without RTF_SORT the things are in the order the blockmap
+// iterator finds them.
+//
+//===========================================================================
+
+void P_GetThingsInRadius(TArray<FRadiusThing> &result, const DVector3 &pos, double radius, sector_t *sec, int flags)
+{
+	result.Clear();
+	if (radius < 0)
+	{
+		return;
+	}
+	if (sec == nullptr)
+	{
+		sec = P_PointInSector(pos);
+	}
+
+	FPortalGroupArray check(FPortalGroupArray::PGA_Full3d);
+	FMultiBlockThingsIterator it(check, pos.X, pos.Y, pos.Z - radius, radius * 2, radius, false, sec);
+	FMultiBlockThingsIterator::CheckResult cres;
+	int basegroup = sec->PortalGroup;
+	double radiussq = radius * radius;
+
+	validcount++;
+	while (it.Next(&cres))
+	{
+		AActor *thing = cres.thing;
+		if (thing->validcount == validcount)
+		{
+			continue;
+		}
+
+		DVector3 checkpos(pos.XY() + Displacements.getOffset(basegroup, thing->Sector->PortalGroup), pos.Z);
+		DVector3 diff = thing->Pos() - checkpos;
+		double distsq;
+		if (flags & RTF_SPHERE)
+		{
+			diff.Z += thing->Height * 0.5;
+			distsq = diff.LengthSquared();
+		}
+		else
+		{
+			distsq = diff.XY().LengthSquared();
+		}
+		if (distsq > radiussq)
+		{
+			continue;
+		}
+
+		thing->validcount = validcount;
+		FRadiusThing &entry = result[result.Reserve(1)];
+		entry.thing = thing;
+		entry.Position = checkpos;
+		entry.Distance = g_sqrt(distsq);
+		entry.portalflags = cres.portalflags;
+	}
+
+	if (flags & RTF_SORT)
+	{
+		std::stable_sort(result.begin(), result.end(), [](const FRadiusThing &a, const FRadiusThing &b)
+		{
+			return a.Distance < b.Distance;
+		});
+	}
+}
+
 //===========================================================================
 //
 // FPathTraverse :: Intercepts
@@ -352,6 +352,27 @@ public:
 	}
 };
 
+//===========================================================================
+//
+// Radius queries for area effects
+//
+//===========================================================================
+
+enum ERadiusThingsFlags
+{
+	RTF_SPHERE = 1,		// measure the distance to the thing's center in 3D instead of only horizontally
+	RTF_SORT = 2,		// return the closest things first
+};
+
+struct FRadiusThing
+{
+	AActor *thing;
+	DVector3 Position;	// the query position, translated into the thing's portal group
+	double Distance;
+	int portalflags;
+};
+
+void P_GetThingsInRadius(TArray<FRadiusThing> &result, const DVector3 &pos, double radius, sector_t *sec, int flags);
 
 
 class FPathTraverse
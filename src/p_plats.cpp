@@ -85,6 +85,17 @@ const char *DPlat::GetSoundByType () const
 	return m_Type == platDownWaitUpStayStone ? "Floor" : "Platform";
 }
 
+//
+// Predict a plat's movement without changing its state
+//
+void DPlat::Predict ()
+{
+	if (m_Status == up)
+		PredictPlane(sector_t::floor, m_Speed, m_High, 1);
+	else if (m_Status == down)
+		PredictPlane(sector_t::floor, m_Speed, m_Low, -1);
+}
+
 //
 // Move a plat up and down
 //
@@ -0,0 +1,765 @@
+/*
+** p_rejectbuilder.cpp
+** Builds a REJECT table for maps that don't come with one
+**
+**---------------------------------------------------------------------------
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+** The table answers one question for P_CheckSight: can any straight line
+** from a point in sector A reach a point in sector B without crossing a
+** one-sided line? Heights, line flags and polyobjects are ignored, because
+** all of them can change while the map is running and can only block more,
+** never less. If such a line may exist, the pair is never rejected.
+**
+** The work is done on the GL subsectors, which are convex, so a sight line
+** enters each of them at most once. Starting from every subsector, the
+** flow follows the chains of subsector boundaries ('portals') that a
+** single line could pass through, and narrows the part of each boundary
+** that is still reachable, as Quake's vis tool does. Before that, a cheap
+** flood finds for each portal the sectors that could possibly be seen
+** through it. The recursion uses these to stop as soon as it can't
+** discover anything new.
+*/
+
+#include <math.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <zlib.h>
+
+#include "templates.h"
+#include "doomtype.h"
+#include "c_cvars.h"
+#include "c_dispatch.h"
+#include "m_swap.h"
+#include "files.h"
+#include "p_setup.h"
+#include "portal.h"
+#include "i_time.h"
+#include "g_levellocals.h"
+
+// Off by default: a generated table changes which sight checks call
+// pr_checksight, so it must match between all players and demo recordings.
+CVAR (Bool, genreject, false, CVAR_SERVERINFO|CVAR_GLOBALCONFIG);
+CVAR (Bool, cachereject, true, CVAR_ARCHIVE|CVAR_GLOBALCONFIG);
+
+enum
+{
+	REJECT_CACHE_VERSION = 1,
+	MAX_REJECT_SECTORS = 16384,			// keeps the table and the visibility bits at 32 MB each
+	MAX_MIGHTSEE_BYTES = 32 << 20,
+	MAX_FLOW_STEPS = 1 << 20,			// per source sector
+	MAX_TOTAL_FLOW_STEPS = 1 << 25,		// for the whole map, beyond this no table is built
+};
+
+static const double REJECT_EPSILON = 1. / 16;
+
+//==========================================================================
+//
+// Data shared by all worker threads
+//
+//==========================================================================
+
+struct FRejectPortal
+{
+	DVector2 v1, v2;
+	DVector2 normal;		// points away from the leaf the portal leaves
+	double dist;			// plane distance, so that Side() > 0 is beyond the portal
+	int leaf;				// leaf on the other side
+	bool degenerate;
+
+	double Side(const DVector2 &pt) const
+	{
+		return (pt | normal) - dist;
+	}
+};
+
+struct FRejectLeaf
+{
+	int sector;
+	int firstportal;
+	int numportals;
+};
+
+struct FRejectWinding
+{
+	DVector2 v1, v2;
+};
+
+class FRejectBuilder
+{
+public:
+	FRejectBuilder();
+	bool Build(TArray<uint8_t> &reject);
+
+private:
+	struct FWorker
+	{
+		TArray<int> Stamp;
+		int CurStamp = 0;
+		TArray<int> Stack;
+		TArray<bool> OnPath;
+		TArray<uint32_t> Visible;
+		TArray<TArray<uint32_t>> MightStack;
+		unsigned Steps;
+		bool Aborted;
+	};
+
+	void MakePortals();
+	void FloodPortal(FWorker &w, int portalnum);
+	void FlowSector(FWorker &w, int sectornum);
+	void RecursiveFlow(FWorker &w, int leaf, const FRejectPortal &src, const FRejectWinding *pass, const uint32_t *might, int depth);
+	template<class F> void RunWorkers(int count, F func);
+	void CombineDirections();
+	void LoadTile(uint32_t *tile, int rowblock, int word);
+	void StoreTile(const uint32_t *tile, int rowblock, int word);
+	static void TransposeTile(uint32_t *tile);
+
+	uint32_t *MightSee(int portal) { return &MightSeeBits[size_t(portal) * SectorWords]; }
+	uint32_t *VisRow(int sector) { return &VisBits[size_t(sector) * SectorWords]; }
+
+	static bool ClipWinding(FRejectWinding &w, const DVector2 &normal, double dist);
+	static bool ClipToSeparators(FRejectWinding &target, const FRejectPortal &src, const FRejectWinding &pass);
+
+	TArray<FRejectPortal> Portals;
+	TArray<FRejectLeaf> Leaves;
+	TArray<TArray<int>> SectorLeaves;
+	TArray<bool> AlwaysVisible;
+	TArray<uint32_t> MightSeeBits;
+	TArray<uint32_t> VisBits;
+	int NumSectors;
+	int SectorWords;
+	std::atomic<int64_t> TotalSteps{ 0 };
+	std::atomic<bool> OverBudget{ false };
+};
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
+FRejectBuilder::FRejectBuilder()
+{
+	NumSectors = level.sectors.Size();
+	SectorWords = (NumSectors + 31) >> 5;
+}
+
+//==========================================================================
+//
+// FRejectBuilder :: MakePortals
+//
+// Every seg with a partner that is either a miniseg or part of a line
+// with a back sector becomes a portal from its own subsector into its
+// partner's.
+//
+//==========================================================================
+
+void FRejectBuilder::MakePortals()
+{
+	Leaves.Resize(level.subsectors.Size());
+	SectorLeaves.Resize(NumSectors);
+	AlwaysVisible.Resize(NumSectors);
+	for (int i = 0; i < NumSectors; i++)
+	{
+		AlwaysVisible[i] = false;
+	}
+
+	for (auto &sub : level.subsectors)
+	{
+		FRejectLeaf &leaf = Leaves[sub.Index()];
+		leaf.sector = sub.sector->Index();
+		leaf.firstportal = Portals.Size();
+		leaf.numportals = 0;
+		SectorLeaves[leaf.sector].Push(sub.Index());
+
+		DVector2 center(0, 0);
+		for (uint32_t i = 0; i < sub.numlines; i++)
+		{
+			center += sub.firstline[i].v1->fPos();
+		}
+		if (sub.numlines > 0) center /= sub.numlines;
+
+		for (uint32_t i = 0; i < sub.numlines; i++)
+		{
+			seg_t *seg = &sub.firstline[i];
+			if (seg->PartnerSeg == nullptr || seg->PartnerSeg->Subsector == nullptr) continue;
+			if (seg->linedef != nullptr && seg->linedef->backsector == nullptr) continue;
+
+			FRejectPortal portal;
+			portal.v1 = seg->v1->fPos();
+			portal.v2 = seg->v2->fPos();
+			portal.leaf = seg->PartnerSeg->Subsector->Index();
+
+			DVector2 delta = portal.v2 - portal.v1;
+			double len = delta.Length();
+			portal.degenerate = len < REJECT_EPSILON;
+			if (!portal.degenerate)
+			{
+				portal.normal = DVector2(-delta.Y, delta.X) / len;
+				portal.dist = portal.v1 | portal.normal;
+				if (portal.Side(center) > 0)
+				{
+					portal.normal = -portal.normal;
+					portal.dist = -portal.dist;
+				}
+			}
+			else
+			{
+				portal.normal.Zero();
+				portal.dist = 0;
+			}
+			Portals.Push(portal);
+			leaf.numportals++;
+		}
+	}
+
+	// Sectors with self-referencing lines are usually render hacks whose
+	// sector assignment depends on the node builder. Don't trust them.
+	for (auto &line : level.lines)
+	{
+		if (line.backsector != nullptr && line.frontsector == line.backsector)
+		{
+			AlwaysVisible[line.frontsector->Index()] = true;
+		}
+	}
+	for (int i = 0; i < NumSectors; i++)
+	{
+		if (SectorLeaves[i].Size() == 0) AlwaysVisible[i] = true;
+	}
+}
+
+//==========================================================================
+//
+// FRejectBuilder :: FloodPortal
+//
+// Collects all sectors behind a portal that are reachable through other
+// portals that lie at least partly beyond it and that the first portal
+// lies at least partly in front of. A sight line through this portal can
+// only ever reach one of these sectors.
+//
+//==========================================================================
+
+void FRejectBuilder::FloodPortal(FWorker &w, int portalnum)
+{
+	const FRejectPortal &p = Portals[portalnum];
+	uint32_t *might = MightSee(portalnum);
+
+	if (++w.CurStamp == 0)
+	{
+		for (auto &s : w.Stamp) s = 0;
+		w.CurStamp = 1;
+	}
+
+	w.Stack.Clear();
+	w.Stack.Push(p.leaf);
+	w.Stamp[p.leaf] = w.CurStamp;
+
+	while (w.Stack.Size() > 0)
+	{
+		int leafnum;
+		w.Stack.Pop(leafnum);
+		const FRejectLeaf &leaf = Leaves[leafnum];
+		might[leaf.sector >> 5] |= 1u << (leaf.sector & 31);
+
+		for (int i = 0; i < leaf.numportals; i++)
+		{
+			const FRejectPortal &q = Portals[leaf.firstportal + i];
+			if (w.Stamp[q.leaf] == w.CurStamp) continue;
+
+			if (!p.degenerate && p.Side(q.v1) < -REJECT_EPSILON && p.Side(q.v2) < -REJECT_EPSILON)
+			{
+				continue;	// entirely behind the source
+			}
+			if (!q.degenerate && q.Side(p.v1) > REJECT_EPSILON && q.Side(p.v2) > REJECT_EPSILON)
+			{
+				continue;	// the source is entirely beyond this portal
+			}
+			w.Stamp[q.leaf] = w.CurStamp;
+			w.Stack.Push(q.leaf);
+		}
+	}
+}
+
+//==========================================================================
+//
+// FRejectBuilder :: ClipWinding
+//
+// Keeps the part of a winding that is on the positive side of a plane.
+// Returns false if nothing is left.
+//
+//==========================================================================
+
+bool FRejectBuilder::ClipWinding(FRejectWinding &w, const DVector2 &normal, double dist)
+{
+	double d1 = (w.v1 | normal) - dist + REJECT_EPSILON;
+	double d2 = (w.v2 | normal) - dist + REJECT_EPSILON;
+
+	if (d1 >= 0 && d2 >= 0) return true;
+	if (d1 < 0 && d2 < 0) return false;
+
+	DVector2 mid = w.v1 + (w.v2 - w.v1) * (d1 / (d1 - d2));
+	if (d1 < 0) w.v1 = mid;
+	else w.v2 = mid;
+	return true;
+}
+
+//==========================================================================
+//
+// FRejectBuilder :: ClipToSeparators
+//
+// A line through a point of the source and a point of the pass portal
+// can only continue into the area bounded by the lines that go through
+// an end point of each and have the source on one side and the pass
+// portal on the other.
+//
+//==========================================================================
+
+bool FRejectBuilder::ClipToSeparators(FRejectWinding &target, const FRejectPortal &src, const FRejectWinding &pass)
+{
+	const DVector2 *srcpt[2] = { &src.v1, &src.v2 };
+	const DVector2 *passpt[2] = { &pass.v1, &pass.v2 };
+
+	for (int i = 0; i < 2; i++)
+	{
+		for (int j = 0; j < 2; j++)
+		{
+			const DVector2 &e = *srcpt[i];
+			const DVector2 &f = *passpt[j];
+			DVector2 delta = f - e;
+			double len = delta.Length();
+			if (len < REJECT_EPSILON) continue;
+
+			DVector2 normal = DVector2(-delta.Y, delta.X) / len;
+			double dist = e | normal;
+			double de = (*srcpt[i ^ 1] | normal) - dist;
+			double df = (*passpt[j ^ 1] | normal) - dist;
+
+			// Orient the plane so that the pass portal is on the positive side.
+			if (df < 0 || (df == 0 && de > 0))
+			{
+				normal = -normal;
+				dist = -dist;
+				de = -de;
+				df = -df;
+			}
+			if (de > 0 || (de == 0 && df == 0))
+			{
+				continue;	// not a separator
+			}
+			if (!ClipWinding(target, normal, dist))
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+//==========================================================================
+//
+// FRejectBuilder :: RecursiveFlow
+//
+//==========================================================================
+
+void FRejectBuilder::RecursiveFlow(FWorker &w, int leafnum, const FRejectPortal &src, const FRejectWinding *pass, const uint32_t *might, int depth)
+{
+	if (++w.Steps > MAX_FLOW_STEPS || OverBudget.load(std::memory_order_relaxed))
+	{
+		w.Aborted = true;
+		return;
+	}
+
+	const FRejectLeaf &leaf = Leaves[leafnum];
+	uint32_t *visible = w.Visible.Data();
+	visible[leaf.sector >> 5] |= 1u << (leaf.sector & 31);
+
+	// Deeper levels may grow MightStack, but the buffers themselves stay put.
+	if ((int)w.MightStack.Size() <= depth)
+	{
+		w.MightStack.Resize(depth + 1);
+		w.MightStack[depth].Resize(SectorWords);
+	}
+	uint32_t *newmight = w.MightStack[depth].Data();
+
+	w.OnPath[leafnum] = true;
+	for (int i = 0; i < leaf.numportals && !w.Aborted; i++)
+	{
+		const FRejectPortal &q = Portals[leaf.firstportal + i];
+		if (w.OnPath[q.leaf]) continue;
+
+		// Stop if nothing that can be seen through this portal is new.
+		const uint32_t *qmight = MightSee(leaf.firstportal + i);
+		uint32_t more = 0;
+		for (int j = 0; j < SectorWords; j++)
+		{
+			newmight[j] = might[j] & qmight[j];
+			more |= newmight[j] & ~visible[j];
+		}
+		if (more == 0) continue;
+
+		FRejectWinding target = { q.v1, q.v2 };
+		if (!src.degenerate && !ClipWinding(target, src.normal, src.dist)) continue;
+		if (pass != nullptr && !ClipToSeparators(target, src, *pass)) continue;
+
+		RecursiveFlow(w, q.leaf, src, &target, newmight, depth + 1);
+	}
+	w.OnPath[leafnum] = false;
+}
+
+//==========================================================================
+//
+// FRejectBuilder :: FlowSector
+//
+// Finds all sectors that may be visible from any subsector of a sector.
+// If this takes too long, everything behind the sector's own portals
+// counts as visible.
+//
+//==========================================================================
+
+void FRejectBuilder::FlowSector(FWorker &w, int sectornum)
+{
+	uint32_t *row = VisRow(sectornum);
+
+	if (AlwaysVisible[sectornum])
+	{
+		for (int j = 0; j < SectorWords; j++) row[j] = ~0u;
+		return;
+	}
+	if (OverBudget)
+	{
+		return;
+	}
+
+	w.Visible.Resize(SectorWords);
+	memset(w.Visible.Data(), 0, SectorWords * sizeof(uint32_t));
+	w.Visible[sectornum >> 5] |= 1u << (sectornum & 31);
+	w.Steps = 0;
+	w.Aborted = false;
+
+	for (int leafnum : SectorLeaves[sectornum])
+	{
+		const FRejectLeaf &leaf = Leaves[leafnum];
+		w.OnPath[leafnum] = true;
+		for (int i = 0; i < leaf.numportals && !w.Aborted; i++)
+		{
+			const FRejectPortal &p = Portals[leaf.firstportal + i];
+			if (w.OnPath[p.leaf]) continue;
+			RecursiveFlow(w, p.leaf, p, nullptr, MightSee(leaf.firstportal + i), 0);
+		}
+		w.OnPath[leafnum] = false;
+		if (w.Aborted) break;
+	}
+
+	// Each sector's step count doesn't depend on the order the workers run
+	// in, so whether the total goes over budget doesn't either.
+	if ((TotalSteps += w.Steps) > MAX_TOTAL_FLOW_STEPS)
+	{
+		OverBudget = true;
+		return;
+	}
+
+	if (w.Aborted)
+	{
+		for (int leafnum : SectorLeaves[sectornum])
+		{
+			const FRejectLeaf &leaf = Leaves[leafnum];
+			for (int i = 0; i < leaf.numportals; i++)
+			{
+				const uint32_t *might = MightSee(leaf.firstportal + i);
+				for (int j = 0; j < SectorWords; j++) w.Visible[j] |= might[j];
+			}
+		}
+	}
+	memcpy(row, w.Visible.Data(), SectorWords * sizeof(uint32_t));
+}
+
+//==========================================================================
+//
+// FRejectBuilder :: RunWorkers
+//
+// Calls func(worker, index) for every index in [0, count), spread over
+// all available cores.
+//
+//==========================================================================
+
+template<class F>
+void FRejectBuilder::RunWorkers(int count, F func)
+{
+	int numthreads = clamp<int>(std::thread::hardware_concurrency(), 1, 16);
+	std::atomic<int> next(0);
+	TArray<FWorker> workers(numthreads, true);
+	std::vector<std::thread> threads;
+
+	auto work = [&](FWorker &w)
+	{
+		w.Stamp.Resize(Leaves.Size());
+		w.OnPath.Resize(Leaves.Size());
+		for (auto &s : w.Stamp) s = 0;
+		for (auto &o : w.OnPath) o = false;
+		int index;
+		while ((index = next++) < count)
+		{
+			func(w, index);
+		}
+	};
+
+	for (int i = 1; i < numthreads; i++)
+	{
+		threads.emplace_back(work, std::ref(workers[i]));
+	}
+	work(workers[0]);
+	for (auto &t : threads)
+	{
+		t.join();
+	}
+}
+
+//==========================================================================
+//
+// FRejectBuilder :: CombineDirections
+//
+// Each direction gives a conservative answer, so a pair is only visible
+// if both directions agree on it. This ANDs the visibility bits with their
+// transpose in place, a 32x32 tile at a time, so that the columns are not
+// read one word per row.
+//
+//==========================================================================
+
+void FRejectBuilder::LoadTile(uint32_t *tile, int rowblock, int word)
+{
+	for (int k = 0; k < 32; k++)
+	{
+		int row = rowblock * 32 + k;
+		tile[k] = row < NumSectors ? VisRow(row)[word] : 0;
+	}
+}
+
+void FRejectBuilder::StoreTile(const uint32_t *tile, int rowblock, int word)
+{
+	for (int k = 0; k < 32; k++)
+	{
+		int row = rowblock * 32 + k;
+		if (row < NumSectors) VisRow(row)[word] = tile[k];
+	}
+}
+
+// Bit c of word r ends up as bit r of word c.
+void FRejectBuilder::TransposeTile(uint32_t *tile)
+{
+	uint32_t m = 0x0000ffff;
+	for (int j = 16; j != 0; j >>= 1, m ^= m << j)
+	{
+		for (int k = 0; k < 32; k = (k + j + 1) & ~j)
+		{
+			uint32_t x = ((tile[k] >> j) ^ tile[k + j]) & m;
+			tile[k] ^= x << j;
+			tile[k + j] ^= x;
+		}
+	}
+}
+
+void FRejectBuilder::CombineDirections()
+{
+	uint32_t a[32], b[32];
+
+	for (int bi = 0; bi < SectorWords; bi++)
+	{
+		for (int bj = bi; bj < SectorWords; bj++)
+		{
+			LoadTile(a, bi, bj);
+			LoadTile(b, bj, bi);
+			TransposeTile(b);
+			for (int k = 0; k < 32; k++)
+			{
+				a[k] &= b[k];
+			}
+			StoreTile(a, bi, bj);
+			TransposeTile(a);
+			StoreTile(a, bj, bi);
+		}
+	}
+}
+
+//==========================================================================
+//
+// FRejectBuilder :: Build
+//
+//==========================================================================
+
+bool FRejectBuilder::Build(TArray<uint8_t> &reject)
+{
+	MakePortals();
+
+	if ((size_t)Portals.Size() * SectorWords * sizeof(uint32_t) > MAX_MIGHTSEE_BYTES)
+	{
+		DPrintf(DMSG_NOTIFY, "Too many portals (%u) to build a REJECT table\n", Portals.Size());
+		return false;
+	}
+
+	MightSeeBits.Resize(Portals.Size() * SectorWords);
+	memset(MightSeeBits.Data(), 0, MightSeeBits.Size() * sizeof(uint32_t));
+	RunWorkers(Portals.Size(), [this](FWorker &w, int i) { FloodPortal(w, i); });
+
+	VisBits.Resize(NumSectors * SectorWords);
+	RunWorkers(NumSectors, [this](FWorker &w, int i) { FlowSector(w, i); });
+	if (OverBudget)
+	{
+		DPrintf(DMSG_NOTIFY, "REJECT generation took too many steps, not building a table\n");
+		return false;
+	}
+
+	CombineDirections();
+
+	const size_t size = (size_t(NumSectors) * NumSectors + 7) >> 3;
+	reject.Resize(size);
+	memset(reject.Data(), 0, size);
+	for (int s1 = 0; s1 < NumSectors; s1++)
+	{
+		const uint32_t *row = VisRow(s1);
+		for (int s2 = 0; s2 < NumSectors; s2++)
+		{
+			bool visible = !!(row[s2 >> 5] & (1u << (s2 & 31)));
+			if (!AlwaysVisible[s1] && !AlwaysVisible[s2] && !visible)
+			{
+				size_t pnum = size_t(s1) * NumSectors + s2;
+				reject[pnum >> 3] |= 1 << (pnum & 7);
+			}
+		}
+	}
+	return true;
+}
+
+//==========================================================================
+//
+// Reject caching
+//
+// The table only depends on the map's geometry, so it is stored in the
+// node cache directory, keyed by the map's checksum.
+//
+//==========================================================================
+
+static bool LoadCachedReject(int maplump)
+{
+	FString path = P_GetMapCacheName(maplump, false, "grj");
+	FileReader fr;
+	char magic[4];
+	uint32_t header[3];
+	uint8_t md5[16];
+
+	if (!fr.OpenFile(path)) return false;
+	if (fr.Read(magic, 4) != 4 || memcmp(magic, "REJC", 4)) return false;
+	if (fr.Read(header, 12) != 12) return false;
+	if (LittleLong(header[0]) != REJECT_CACHE_VERSION) return false;
+	if (LittleLong(header[1]) != level.sectors.Size()) return false;
+	if (LittleLong(header[2]) != level.lines.Size()) return false;
+	if (fr.Read(md5, 16) != 16 || memcmp(md5, level.md5, 16)) return false;
+
+	auto compressed = fr.Read(fr.GetLength() - fr.Tell());
+	uLongf outlen = (uLongf(level.sectors.Size()) * level.sectors.Size() + 7) >> 3;
+	level.rejectmatrix.Resize(outlen);
+	uLongf gotlen = outlen;
+	if (uncompress(level.rejectmatrix.Data(), &gotlen, compressed.Data(), compressed.Size()) != Z_OK || gotlen != outlen)
+	{
+		level.rejectmatrix.Reset();
+		return false;
+	}
+	return true;
+}
+
+static void SaveCachedReject(int maplump)
+{
+	uLongf outlen = compressBound(level.rejectmatrix.Size());
+	TArray<Bytef> compressed(outlen, true);
+	if (compress(compressed.Data(), &outlen, level.rejectmatrix.Data(), level.rejectmatrix.Size()) != Z_OK)
+	{
+		return;
+	}
+
+	FString path = P_GetMapCacheName(maplump, true, "grj");
+	FileWriter *fw = FileWriter::Open(path);
+	if (fw == nullptr)
+	{
+		Printf("Cannot open reject file %s for writing\n", path.GetChars());
+		return;
+	}
+
+	uint32_t header[3] = { LittleLong(uint32_t(REJECT_CACHE_VERSION)), LittleLong(level.sectors.Size()), LittleLong(level.lines.Size()) };
+	if (fw->Write("REJC", 4) != 4 || fw->Write(header, 12) != 12 || fw->Write(level.md5, 16) != 16 ||
+		fw->Write(compressed.Data(), outlen) != outlen)
+	{
+		Printf("Error saving reject to file %s\n", path.GetChars());
+	}
+	delete fw;
+}
+
+//==========================================================================
+//
+// P_BuildReject
+//
+// Creates a REJECT table if the map doesn't have a usable one. This must
+// be called after the portals have been set up, since sight checks
+// through linked portals can't use a table indexed by sector pairs.
+//
+//==========================================================================
+
+void P_BuildReject()
+{
+	if (!genreject || level.rejectmatrix.Size() > 0 || !hasglnodes)
+	{
+		return;
+	}
+	if (level.sectors.Size() < 2 || level.sectors.Size() > MAX_REJECT_SECTORS)
+	{
+		return;
+	}
+	// Portals can make things visible that are not in a straight line.
+	if (Displacements.size > 1 || linePortals.Size() > 0)
+	{
+		return;
+	}
+
+	if (cachereject && LoadCachedReject(level.lumpnum))
+	{
+		DPrintf(DMSG_NOTIFY, "Using cached REJECT table\n");
+		return;
+	}
+
+	uint64_t startTime = I_msTime();
+	FRejectBuilder builder;
+	if (!builder.Build(level.rejectmatrix))
+	{
+		level.rejectmatrix.Reset();
+		return;
+	}
+	uint64_t endTime = I_msTime();
+	DPrintf(DMSG_NOTIFY, "REJECT generation took %.3f sec\n", (endTime - startTime) * 0.001);
+
+	if (cachereject)
+	{
+		SaveCachedReject(level.lumpnum);
+	}
+}
@@ -30,6 +30,7 @@
 #include "p_blockmap.h"
 #include "memarena.h"
 #include "actor.h"
+#include "po_man.h"
 
 //=============================================================================
 // phares 3/21/98
@@ -214,6 +215,101 @@ void P_DelSeclist(portnode_t *node, portnode_t *FLinePortal::*sechead)
 }
 
 
+//=============================================================================
+//
+// P_MarkSecnodes / P_SweepSecnodes
+//
+// Lists are rebuilt by clearing the m_thing field of every node, letting
+// P_AddSecnode set it again for everything that is still touched and
+// then deleting the nodes where it is still nullptr. This way nodes only
+// go back to the freelist when the thing actually leaves a sector.
+//
+//=============================================================================
+
+template<class nodetype>
+static void P_MarkSecnodes(nodetype *node)
+{
+	while (node)
+	{
+		node->m_thing = nullptr;
+		node = node->m_tnext;
+	}
+}
+
+template<class nodetype, class linktype>
+static nodetype *P_SweepSecnodes(nodetype *list, nodetype *linktype::*listhead)
+{
+	nodetype *node = list;
+	while (node)
+	{
+		if (node->m_thing == nullptr)
+		{
+			if (node == list)
+				list = node->m_tnext;
+			node = P_DelSecnode(node, listhead);
+		}
+		else
+		{
+			node = node->m_tnext;
+		}
+	}
+	return list;
+}
+
+//=============================================================================
+//
+// SecNodeSlack
+//
+// Returns how far the box can be moved along either axis before the
+// line's inRange / BoxOnLineSide result may change.
+//
+//=============================================================================
+
+static double SecNodeSlack(const FBoundingBox &box, const line_t *ld, bool crosses)
+{
+	double range[4] =
+	{
+		ld->bbox[BOXRIGHT] - box.Left(),
+		box.Right() - ld->bbox[BOXLEFT],
+		box.Top() - ld->bbox[BOXBOTTOM],
+		ld->bbox[BOXTOP] - box.Bottom()
+	};
+	DVector2 delta = ld->Delta();
+	if (delta.X == 0 && delta.Y == 0)
+	{
+		return 0;
+	}
+	DVector2 center((box.Left() + box.Right()) / 2, (box.Bottom() + box.Top()) / 2);
+	double halfsize = (box.Right() - box.Left()) / 2;
+	// How far the box reaches past the line, measured in the same units as the box's movement.
+	double straddle = halfsize - fabs((center.X - ld->v1->fX()) * delta.Y - (center.Y - ld->v1->fY()) * delta.X) / (fabs(delta.X) + fabs(delta.Y));
+
+	if (crosses)
+	{
+		return MIN(MIN(MIN(range[0], range[1]), MIN(range[2], range[3])), straddle);
+	}
+	else
+	{
+		return MAX(MAX(MAX(-range[0], -range[1]), MAX(-range[2], -range[3])), -straddle);
+	}
+}
+
+//=============================================================================
+//
+// BlockSlack
+//
+// Returns how far a coordinate can move before it ends up in another
+// blockmap column or row.
+//
+//=============================================================================
+
+static double BlockSlack(double pos, double origin)
+{
+	double v = (pos - origin) / FBlockmap::MAPBLOCKUNITS;
+	double frac = v - floor(v);
+	return MIN(frac, 1. - frac) * FBlockmap::MAPBLOCKUNITS;
+}
+
 //=============================================================================
 // phares 3/14/98
 //
@@ -221,31 +317,47 @@ void P_DelSeclist(portnode_t *node, portnode_t *FLinePortal::*sechead)
 //
 // Alters/creates the sector_list that shows what sectors the object resides in
 //
+// If a cache is passed, the list is returned unchanged as long as the thing
+// stays within the same blockmap blocks and no line changes whether it
+// crosses the thing's box, since a full rebuild would find exactly the same
+// sectors then.
+//
 //=============================================================================
 
-msecnode_t *P_CreateSecNodeList(AActor *thing, double radius, msecnode_t *sector_list, msecnode_t *sector_t::*seclisthead)
+msecnode_t *P_CreateSecNodeList(AActor *thing, double radius, msecnode_t *sector_list, msecnode_t *sector_t::*seclisthead, FSecNodeCache *cache)
 {
-	msecnode_t *node;
+	if (cache != nullptr && sector_list != nullptr && sector_list == cache->list && thing->Sector == cache->sector &&
+		radius == cache->radius && FPolyObj::LinkGeneration == cache->polygeneration)
+	{
+		DVector2 move = thing->Pos().XY() - cache->pos;
+		if (fabs(move.X) < cache->slack && fabs(move.Y) < cache->slack)
+		{
+			return sector_list;
+		}
+	}
 
 	// First, clear out the existing m_thing fields. As each node is
 	// added or verified as needed, m_thing will be set properly. When
 	// finished, delete all nodes where m_thing is still nullptr. These
 	// represent the sectors the Thing has vacated.
 
-	node = sector_list;
-	while (node)
-	{
-		node->m_thing = nullptr;
-		node = node->m_tnext;
-	}
+	P_MarkSecnodes(sector_list);
 
 	FBoundingBox box(thing->X(), thing->Y(), radius);
 	FBlockLinesIterator it(box);
 	line_t *ld;
+	double slack = MIN(MIN(BlockSlack(box.Left(), level.blockmap.bmaporgx), BlockSlack(box.Right(), level.blockmap.bmaporgx)),
+		MIN(BlockSlack(box.Bottom(), level.blockmap.bmaporgy), BlockSlack(box.Top(), level.blockmap.bmaporgy)));
 
 	while ((ld = it.Next()))
 	{
-		if (!box.inRange(ld) || box.BoxOnLineSide(ld) != -1)
+		bool crosses = box.inRange(ld) && box.BoxOnLineSide(ld) == -1;
+
+		if (cache != nullptr && slack > 0)
+		{
+			slack = MIN(slack, SecNodeSlack(box, ld, crosses));
+		}
+		if (!crosses)
 			continue;
 
 		// This line crosses through the object.
@@ -275,19 +387,17 @@ msecnode_t *P_CreateSecNodeList(AActor *thing, double radius, msecnode_t *sector
 	// Now delete any nodes that won't be used. These are the ones where
 	// m_thing is still nullptr.
 
-	node = sector_list;
-	while (node)
+	sector_list = P_SweepSecnodes(sector_list, seclisthead);
+
+	if (cache != nullptr)
 	{
-		if (node->m_thing == nullptr)
-		{
-			if (node == sector_list)
-				sector_list = node->m_tnext;
-			node = P_DelSecnode(node, seclisthead);
-		}
-		else
-		{
-			node = node->m_tnext;
-		}
+		// Stay clear of rounding differences near the limits.
+		cache->list = sector_list;
+		cache->sector = thing->Sector;
+		cache->pos = thing->Pos().XY();
+		cache->radius = radius;
+		cache->slack = slack - 1. / 64;
+		cache->polygeneration = FPolyObj::LinkGeneration;
 	}
 	return sector_list;
 }
@@ -339,43 +449,6 @@ portnode_t *P_DelPortalnode(portnode_t *node)
 }
 
 
-//=============================================================================
-//
-// P_AddPortalnode
-//
-//=============================================================================
-
-portnode_t *P_AddPortalnode(FLinePortal *s, AActor *thing, portnode_t *nextnode)
-{
-	portnode_t *node;
-
-	if (s == 0)
-	{
-		I_FatalError("AddSecnode of 0 for %s\n", thing->GetClass()->TypeName.GetChars());
-	}
-
-	node = reinterpret_cast<portnode_t*>(P_GetSecnode());
-
-	// killough 4/4/98, 4/7/98: mark new nodes unvisited.
-	node->visited = 0;
-
-	node->m_sector = s; 			// portal
-	node->m_thing = thing; 			// mobj
-	node->m_tprev = nullptr;			// prev node on Thing thread
-	node->m_tnext = nextnode;		// next node on Thing thread
-	if (nextnode)
-		nextnode->m_tprev = node;	// set back link on Thing
-
-									// Add new node at head of portal thread starting at s->touching_thinglist
-
-	node->m_sprev = nullptr;			// prev node on portal thread
-	node->m_snext = s->lineportal_thinglist; // next node on portal thread
-	if (s->lineportal_thinglist)
-		node->m_snext->m_sprev = node;
-	s->lineportal_thinglist = node;
-	return node;
-}
-
 //==========================================================================
 //
 // Handle the lists used to render actors from other portal areas
@@ -388,7 +461,7 @@ void AActor::UpdateRenderSectorList()
 	if (Pos() != OldRenderPos && !(flags & MF_NOSECTOR))
 	{
 		// Only check if the map contains line portals
-		ClearRenderLineList();
+		P_MarkSecnodes(touching_lineportallist);
 		if (PortalBlockmap.containsLines && Pos().XY() != OldRenderPos.XY())
 		{
 			int bx = level.blockmap.GetBlockX(X());
@@ -403,14 +476,16 @@ void AActor::UpdateRenderSectorList()
 					if (p.mType == PORTT_VISUAL) continue;
 					if (bb.inRange(p.mOrigin) && bb.BoxOnLineSide(p.mOrigin))
 					{
-						touching_lineportallist = P_AddPortalnode(&p, this, touching_lineportallist);
+						touching_lineportallist = P_AddSecnode(&p, this, touching_lineportallist, p.lineportal_thinglist);
 					}
 				}
 			}
 		}
+		touching_lineportallist = P_SweepSecnodes(touching_lineportallist, &FLinePortal::lineportal_thinglist);
+
 		sector_t *sec = Sector;
 		double lasth = -FLT_MAX;
-		ClearRenderSectorList();
+		P_MarkSecnodes(touching_sectorportallist);
 		while (!sec->PortalBlocksMovement(sector_t::ceiling))
 		{
 			double planeh = sec->GetPortalPlaneZ(sector_t::ceiling);
@@ -433,6 +508,7 @@ void AActor::UpdateRenderSectorList()
 			sec = P_PointInSector(newpos);
 			touching_sectorportallist = P_AddSecnode(sec, this, touching_sectorportallist, sec->sectorportal_thinglist);
 		}
+		touching_sectorportallist = P_SweepSecnodes(touching_sectorportallist, &sector_t::sectorportal_thinglist);
 	}
 }
 
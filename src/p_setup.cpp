@@ -3738,6 +3738,8 @@ void P_SetupLevel(const char *lumpname, int position, bool newGame)
 		P_FinalizePortals();	// finalize line portals after polyobjects have been initialized. This info is needed for properly flagging them.
 	times[16].Unclock();
 
+	P_BuildReject();
+
 	assert(sidetemp != NULL);
 	delete[] sidetemp;
 	sidetemp = NULL;
@@ -167,6 +167,8 @@ bool P_LoadGLNodes(MapData * map);
 bool P_CheckNodes(MapData * map, bool rebuilt, int buildtime);
 bool P_CheckForGLNodes();
 void P_SetRenderSector();
+FString P_GetMapCacheName(int maplump, bool create, const char *extension);
+void P_BuildReject();
 
 
 struct sidei_t	// [RH] Only keep BOOM sidedef init stuff around for init
@@ -59,9 +59,60 @@ This uses specialized forms of the maputils routines for optimized performance
 
 // Performance meters
 static int sightcounts[6];
+static int sightcachehits, sightcachemisses;
 static cycle_t SightCycles;
 static cycle_t MaxSightCycles;
 
+//==========================================================================
+//
+// Sight cache
+//
+// Monsters often check sight to the same target several times during one
+// tick, e.g. A_Chase for the melee and the missile range. The result of
+// the line trace is remembered until either actor moves, another thinker
+// starts ticking or P_InvalidateSightCache is called. That happens when
+// a sector moves, a special is executed or ACS changes line blocking, and
+// at the start of a tic and of RunThinkers, since the thinker count is
+// reset there and could otherwise match an entry from an earlier phase.
+// Everything before the trace, including the random checks for invisible
+// targets, is still done on every call.
+//
+//==========================================================================
+
+struct FSightCacheEntry
+{
+	AActor *t1, *t2;
+	DVector3 pos1, pos2;
+	double height1, height2;
+	int flags;
+	int maptime;
+	int thinkcount;
+	int generation;
+	bool result;
+};
+
+enum { SIGHT_CACHE_SIZE = 256 };
+static FSightCacheEntry SightCache[SIGHT_CACHE_SIZE];
+static int SightCacheGeneration = 1;
+
+void P_InvalidateSightCache()
+{
+	SightCacheGeneration++;
+}
+
+static FSightCacheEntry *FindSightCacheEntry(AActor *t1, AActor *t2, int flags, bool &found)
+{
+	size_t hash = (size_t(t1) >> 4) ^ (size_t(t2) >> 3) ^ size_t(flags);
+	FSightCacheEntry *entry = &SightCache[(hash ^ (hash >> 8)) & (SIGHT_CACHE_SIZE - 1)];
+
+	found = entry->generation == SightCacheGeneration &&
+		entry->t1 == t1 && entry->t2 == t2 && entry->flags == flags &&
+		entry->maptime == level.maptime && entry->thinkcount == DThinker::GetThinkCount() &&
+		entry->pos1 == t1->Pos() && entry->pos2 == t2->Pos() &&
+		entry->height1 == t1->Height && entry->height2 == t2->Height;
+	return entry;
+}
+
 enum
 {
 	SO_TOPFRONT = 1,
@@ -845,6 +896,8 @@ int P_CheckSight (AActor *t1, AActor *t2, int flags)
 	SightCycles.Clock();
 
 	bool res;
+	bool cached;
+	FSightCacheEntry *entry;
 
 	if (t1 == nullptr || t2 == nullptr)
 	{
@@ -904,6 +957,15 @@ sightcounts[0]++;
 	// An unobstructed LOS is possible.
 	// Now look from eyes of t1 to any part of t2.
 
+	entry = FindSightCacheEntry(t1, t2, flags, cached);
+	if (cached)
+	{
+		sightcachehits++;
+		res = entry->result;
+		goto done;
+	}
+	sightcachemisses++;
+
 	validcount++;
 	portals.Clear();
 	{
@@ -935,6 +997,18 @@ sightcounts[0]++;
 		}
 	}
 
+	entry->t1 = t1;
+	entry->t2 = t2;
+	entry->pos1 = t1->Pos();
+	entry->pos2 = t2->Pos();
+	entry->height1 = t1->Height;
+	entry->height2 = t2->Height;
+	entry->flags = flags;
+	entry->maptime = level.maptime;
+	entry->thinkcount = DThinker::GetThinkCount();
+	entry->generation = SightCacheGeneration;
+	entry->result = res;
+
 done:
 	SightCycles.Unclock();
 	return res;
@@ -943,9 +1017,11 @@ done:
 ADD_STAT (sight)
 {
 	FString out;
-	out.Format ("%04.1f ms (%04.1f max), %5d %2d%4d%4d%4d%4d\n",
+	int lookups = sightcachehits + sightcachemisses;
+	out.Format ("%04.1f ms (%04.1f max), %5d %2d%4d%4d%4d%4d, cache %d/%d (%d%%)\n",
 		SightCycles.TimeMS(), MaxSightCycles.TimeMS(),
-		sightcounts[3], sightcounts[0], sightcounts[1], sightcounts[2], sightcounts[4], sightcounts[5]);
+		sightcounts[3], sightcounts[0], sightcounts[1], sightcounts[2], sightcounts[4], sightcounts[5],
+		sightcachehits, lookups, lookups > 0 ? sightcachehits * 100 / lookups : 0);
 	return out;
 }
 
@@ -954,6 +1030,7 @@ void P_ResetSightCounters (bool full)
 	if (full)
 	{
 		MaxSightCycles.Reset();
+		P_InvalidateSightCache();
 	}
 	if (SightCycles.Time() > MaxSightCycles.Time())
 	{
@@ -961,4 +1038,5 @@ void P_ResetSightCounters (bool full)
 	}
 	SightCycles.Reset();
 	memset (sightcounts, 0, sizeof(sightcounts));
+	sightcachehits = sightcachemisses = 0;
 }
@@ -195,6 +195,7 @@ public:
 
 	void Serialize(FSerializer &arc);
 	void Tick ();
+	void Predict() override;
 
 	bool IsLift() const { return m_Type == platDownWaitUpStay || m_Type == platDownWaitUpStayStone; }
 	DPlat(sector_t *sector);
@@ -295,6 +296,7 @@ public:
 
 	void Serialize(FSerializer &arc);
 	void Tick ();
+	void Predict() override;
 protected:
 	EVlDoor		m_Type;
 	double	 	m_TopDist;
@@ -425,6 +427,7 @@ public:
 
 	void Serialize(FSerializer &arc);
 	void Tick ();
+	void Predict() override;
 
 protected:
 	ECeiling	m_Type;
@@ -530,6 +533,7 @@ public:
 
 	void Serialize(FSerializer &arc);
 	void Tick ();
+	void Predict() override;
 
 //protected:
 	EFloor	 	m_Type;
@@ -596,6 +600,7 @@ public:
 	void OnDestroy() override;
 	void Serialize(FSerializer &arc);
 	void Tick ();
+	void Predict() override;
 
 protected:
 	EElevator	m_Type;
@@ -136,6 +136,7 @@ void P_Ticker (void)
 		S_ResumeSound (false);
 
 	P_ResetSightCounters (false);
+	P_InvalidateSightCache ();
 	R_ClearInterpolationPath();
 
 	// Reset all actor interpolations for all actors before the current thinking turn so that indirect actor movement gets properly interpolated.
@@ -160,6 +161,7 @@ void P_Ticker (void)
 	E_WorldTick();
 	StatusBar->CallTick ();		// [RH] moved this here
 	level.Tick ();			// [RH] let the level tick
+	P_InvalidateSightCache ();	// RunThinkers starts counting thinkers from 0 again
 	DThinker::RunThinkers ();
 
 	//if added by MC: Freeze mode.
@@ -97,6 +97,7 @@
 #include "g_levellocals.h"
 #include "actorinlines.h"
 #include "r_data/r_translate.h"
+#include "r_data/r_interpolate.h"
 #include "p_acs.h"
 #include "events.h"
 #include "gstrings.h"
@@ -110,6 +111,8 @@ CVAR(Bool, sv_singleplayerrespawn, false, CVAR_SERVERINFO | CVAR_CHEAT)
 // Variables for prediction
 CVAR (Bool, cl_noprediction, false, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
 CVAR(Bool, cl_predict_specials, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+CVAR(Bool, cl_predict_movers, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+CVAR(Bool, cl_predict_missiles, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
 
 CUSTOM_CVAR(Float, cl_predict_lerpscale, 0.05f, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
 {
@@ -157,6 +160,31 @@ static TArray<msecnode_t *> PredictionPortalSectors_sprev_Backup;
 static TArray<FLinePortal *> PredictionPortalLinesBackup;
 static TArray<portnode_t *> PredictionPortalLines_sprev_Backup;
 
+// Sector planes moved ahead by predicted movers, with everything needed to
+// put them and their interpolations back.
+struct PredictPlane
+{
+	sector_t *sector;
+	int pos;
+	DInterpolation *interp;
+	double d, texz;
+	double oldd, oldtexz;
+};
+static TArray<DMover *> PredictionMovers;
+static TArray<PredictPlane> PredictionPlanesBackup;
+
+// Missiles moved ahead for display. Only their sector and render links are
+// changed, so the backup holds what is needed to put those back in place.
+struct PredictMissile
+{
+	AActor *mo;
+	DVector3 pos, prev;
+	sector_t *sector;
+	subsector_t *subsector;
+	AActor **sprev;
+};
+static TArray<PredictMissile> PredictionMissilesBackup;
+
 // [GRB] Custom player classes
 TArray<FPlayerClass> PlayerClasses;
 
@@ -1448,6 +1476,234 @@ nodetype *RestoreNodeList(AActor *act, nodetype *head, nodetype *linktype::*othe
 	return head;
 }
 
+//==========================================================================
+//
+// Predicting the world around the player
+//
+// The local player is the only thing whose future input is known, but
+// sector movers and missiles follow fixed trajectories, so they can be run
+// ahead as well. Without this, lifts and doors lag behind the predicted
+// player by the full network latency. None of this is authoritative: it
+// only changes plane heights and missile positions, and everything is put
+// back in P_UnPredictPlayer before the next real tic runs.
+//
+//==========================================================================
+
+static void BackupPredictPlane(sector_t *sec, int pos)
+{
+	for (auto &plane : PredictionPlanesBackup)
+	{
+		if (plane.sector == sec && plane.pos == pos) return;
+	}
+
+	PredictPlane plane;
+	plane.sector = sec;
+	plane.pos = pos;
+	plane.d = sec->GetSecPlane(pos).fD();
+	plane.texz = sec->GetPlaneTexZ(pos);
+	plane.interp = sec->interpolations[pos == sector_t::floor ? sector_t::FloorMove : sector_t::CeilingMove];
+
+	if (plane.interp != nullptr)
+	{
+		// Fetch the interpolation's start values, which have to be moved
+		// forward along with the plane to keep rendering smooth. The
+		// reference keeps Interpolate from destroying a stationary plane's
+		// interpolation while prediction still uses it; it is released in
+		// P_UnPredictWorld.
+		plane.interp->AddRef();
+		bool changed = plane.interp->Interpolate(0.);
+		plane.oldd = sec->GetSecPlane(pos).fD();
+		plane.oldtexz = sec->GetPlaneTexZ(pos);
+		if (changed) plane.interp->Restore();
+	}
+	else
+	{
+		plane.oldd = plane.d;
+		plane.oldtexz = plane.texz;
+	}
+	PredictionPlanesBackup.Push(plane);
+}
+
+static void P_BackupPredictedMovers()
+{
+	PredictionMovers.Clear();
+	PredictionPlanesBackup.Clear();
+
+	if (!cl_predict_movers)
+	{
+		return;
+	}
+
+	TThinkerIterator<DMover> it;
+	DMover *mover;
+
+	while ((mover = it.Next()) != nullptr)
+	{
+		sector_t *sec = mover->GetSector();
+
+		if (sec == nullptr) continue;
+		PredictionMovers.Push(mover);
+		BackupPredictPlane(sec, sector_t::floor);
+		BackupPredictPlane(sec, sector_t::ceiling);
+	}
+}
+
+static void P_PredictMovers(AActor *act, bool lasttic)
+{
+	if (PredictionMovers.Size() == 0)
+	{
+		return;
+	}
+
+	if (lasttic)
+	{
+		// The last predicted tic is what gets interpolated into.
+		for (auto &plane : PredictionPlanesBackup)
+		{
+			if (plane.interp != nullptr) plane.interp->UpdateInterpolation();
+		}
+	}
+
+	for (auto mover : PredictionMovers)
+	{
+		mover->Predict();
+	}
+
+	// Carry the player along if the floor moved underneath them. This is a
+	// simplified version of what P_ChangeSector does for real moves.
+	double oldfloorz = act->floorz;
+	double oldz = act->Z();
+
+	P_FindFloorCeiling(act);
+	if (act->floorz != oldfloorz && (oldz <= oldfloorz || oldz < act->floorz) && act->Vel.Z <= 0)
+	{
+		act->SetZ(act->floorz);
+		act->player->viewz += act->Z() - oldz;
+	}
+}
+
+static void P_PredictMissileRenderLinks(AActor *mo)
+{
+	if (!(mo->flags & MF_NOSECTOR) && mo->renderradius >= 0)
+	{
+		mo->touching_rendersectors = P_CreateSecNodeList(mo, mo->RenderRadius(), mo->touching_rendersectors, &sector_t::touching_renderthings, &mo->rendersectorcache);
+	}
+	mo->UpdateRenderSectorList();
+}
+
+static void P_PredictMissiles(int tics)
+{
+	PredictionMissilesBackup.Clear();
+
+	if (!cl_predict_missiles || tics <= 0)
+	{
+		return;
+	}
+
+	TThinkerIterator<AActor> it;
+	AActor *mo;
+
+	while ((mo = it.Next()) != nullptr)
+	{
+		// Missiles in the blockmap are left alone, because relinking them
+		// would change the block order that collision checks depend on.
+		if (!(mo->flags & MF_MISSILE) || !(mo->flags & MF_NOBLOCKMAP) || mo->Vel.isZero() || (mo->flags2 & MF2_SEEKERMISSILE))
+		{
+			continue;
+		}
+
+		// Step the way P_XYMovement and P_ZMovement would, minus collisions.
+		DVector3 vel = mo->Vel;
+		DVector3 newpos = mo->Pos();
+		double grav = (mo->flags & MF_NOGRAVITY) ? 0. : mo->GetGravity();
+
+		for (int i = 0; i < tics; i++)
+		{
+			newpos += vel;
+			vel.Z -= grav;
+		}
+
+		// Don't extrapolate past the point where the missile would leave
+		// the sector's space. This is no replacement for a collision check,
+		// but it keeps most missiles from visibly poking through walls.
+		sector_t *sec = P_PointInSector(newpos.XY());
+
+		if (newpos.Z < sec->floorplane.ZatPoint(newpos.XY()) || newpos.Z + mo->Height > sec->ceilingplane.ZatPoint(newpos.XY()))
+		{
+			continue;
+		}
+
+		PredictionMissilesBackup.Push({ mo, mo->Pos(), mo->Prev, mo->Sector, mo->subsector, mo->sprev });
+		mo->Prev += newpos - mo->Pos();
+		mo->SetXYZ(newpos);
+
+		// Move the missile to the new sector's thing list, so that it is
+		// drawn from there and lit by it. The gameplay sector lists and the
+		// blockmap are not touched.
+		if (sec != mo->Sector && !(mo->flags & MF_NOSECTOR))
+		{
+			if ((*mo->sprev = mo->snext))
+				mo->snext->sprev = mo->sprev;
+
+			AActor **link = &sec->thinglist;
+			if ((mo->snext = *link))
+				mo->snext->sprev = &mo->snext;
+			mo->sprev = link;
+			*link = mo;
+		}
+		mo->Sector = sec;
+		mo->subsector = R_PointInSubsector(newpos);
+		P_PredictMissileRenderLinks(mo);
+	}
+}
+
+static void P_UnPredictWorld()
+{
+	// Undo in reverse order, so that every thing list is back in the state
+	// it was in right after the missile left it and the saved link is valid.
+	for (unsigned i = PredictionMissilesBackup.Size(); i-- > 0;)
+	{
+		auto &missile = PredictionMissilesBackup[i];
+		AActor *mo = missile.mo;
+
+		mo->SetXYZ(missile.pos);
+		mo->Prev = missile.prev;
+
+		if (missile.sector != mo->Sector && !(mo->flags & MF_NOSECTOR))
+		{
+			if ((*mo->sprev = mo->snext))
+				mo->snext->sprev = mo->sprev;
+
+			AActor **link = missile.sprev;
+			if ((mo->snext = *link))
+				mo->snext->sprev = &mo->snext;
+			mo->sprev = link;
+			*link = mo;
+		}
+		mo->Sector = missile.sector;
+		mo->subsector = missile.subsector;
+		P_PredictMissileRenderLinks(mo);
+	}
+	PredictionMissilesBackup.Clear();
+
+	for (auto &plane : PredictionPlanesBackup)
+	{
+		sector_t *sec = plane.sector;
+
+		if (plane.interp != nullptr)
+		{
+			sec->GetSecPlane(plane.pos).setD(plane.oldd);
+			sec->SetPlaneTexZ(plane.pos, plane.oldtexz);
+			plane.interp->UpdateInterpolation();
+			plane.interp->DelRef();
+		}
+		sec->GetSecPlane(plane.pos).setD(plane.d);
+		sec->SetPlaneTexZ(plane.pos, plane.texz, true);
+	}
+	PredictionPlanesBackup.Clear();
+	PredictionMovers.Clear();
+}
+
 void P_PredictPlayer (player_t *player)
 {
 	int maxtic;
@@ -1517,6 +1773,8 @@ void P_PredictPlayer (player_t *player)
 	}
 	act->BlockNode = NULL;
 
+	P_BackupPredictedMovers();
+
 	// Values too small to be usable for lerping can be considered "off".
 	bool CanLerp = (!(cl_predict_lerpscale < 0.01f) && (ticdup == 1)), DoLerp = false, NoInterpolateOld = R_GetViewInterpolationStatus();
 	for (int i = gametic; i < maxtic; ++i)
@@ -1524,6 +1782,8 @@ void P_PredictPlayer (player_t *player)
 		if (!NoInterpolateOld)
 			R_RebuildViewInterpolation(player);
 
+		P_PredictMovers(act, i == maxtic - 1);
+
 		player->cmd = localcmds[i % LOCALCMDTICS];
 		P_PlayerThink (player);
 		player->mo->Tick ();
@@ -1545,6 +1805,8 @@ void P_PredictPlayer (player_t *player)
 		}
 	}
 
+	P_PredictMissiles(maxtic - gametic);
+
 	if (CanLerp)
 	{
 		if (NoInterpolateOld)
@@ -1591,6 +1853,8 @@ void P_UnPredictPlayer ()
 			// Q: Can this happen? If yes, can we continue?
 		}
 
+		P_UnPredictWorld();
+
 		AActor *savedcamera = player->camera;
 
 		auto &actInvSel = act->PointerVar<AActor*>(NAME_InvSel);
@@ -1644,6 +1908,9 @@ void P_UnPredictPlayer ()
 			act->touching_rendersectors = RestoreNodeList(act, ctx.render_list, &sector_t::touching_renderthings, PredictionRenderSectors_sprev_Backup, PredictionRenderSectorsBackup);
 			act->touching_sectorportallist = RestoreNodeList(act, sectorportal_list, &sector_t::sectorportal_thinglist, PredictionPortalSectors_sprev_Backup, PredictionPortalSectorsBackup);
 			act->touching_lineportallist = RestoreNodeList(act, lineportal_list, &FLinePortal::lineportal_thinglist, PredictionPortalLines_sprev_Backup, PredictionPortalLinesBackup);
+			// The restored lists were not built by P_CreateSecNodeList.
+			act->sectorlistcache.list = nullptr;
+			act->rendersectorcache.list = nullptr;
 		}
 
 		// Now fix the pointers in the blocknode chain
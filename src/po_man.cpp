@@ -154,6 +154,7 @@ static void ReleaseAllPolyNodes();
 // PUBLIC DATA DEFINITIONS -------------------------------------------------
 
 polyblock_t **PolyBlockMap;
+int FPolyObj::LinkGeneration;
 FPolyObj *polyobjs; // list of all poly-objects on the level
 int po_NumPolyobjs;
 polyspawns_t *polyspawns; // [RH] Let P_SpawnMapThings() find our thingies for us
@@ -813,6 +814,8 @@ FPolyObj::FPolyObj()
 	subsectorlinks = NULL;
 	specialdata = NULL;
 	interpolation = NULL;
+	memset(UnlinkedBBox, 0, sizeof(UnlinkedBBox));
+	UnlinkedGeneration = -1;
 }
 
 //==========================================================================
@@ -949,16 +952,7 @@ bool FPolyObj::MovePolyobj (const DVector2 &pos, bool force)
 
 	if (!force)
 	{
-		bool blocked = false;
-
-		for(unsigned i=0;i < Sidedefs.Size(); i++)
-		{
-			if (CheckMobjBlocking(Sidedefs[i]))
-			{
-				blocked = true;
-			}
-		}
-		if (blocked)
+		if (CheckMobjsBlocking())
 		{
 			DoMovePolyobj (-pos);
 			LinkPolyobj();
@@ -1042,13 +1036,7 @@ bool FPolyObj::RotatePolyobj (DAngle angle, bool fromsave)
 	// If we are loading a savegame we do not really want to damage actors and be blocked by them. This can also cause crashes when trying to damage incompletely deserialized player pawns.
 	if (!fromsave)
 	{
-		for (unsigned i = 0; i < Sidedefs.Size(); i++)
-		{
-			if (CheckMobjBlocking(Sidedefs[i]))
-			{
-				blocked = true;
-			}
-		}
+		blocked = CheckMobjsBlocking();
 		if (blocked)
 		{
 			for(unsigned i=0;i < Vertices.Size(); i++)
@@ -1079,6 +1067,11 @@ void FPolyObj::UnLinkPolyobj ()
 	int i, j;
 	int index;
 
+	LinkGeneration++;
+	UnlinkedSlots.Clear();
+	memcpy(UnlinkedBBox, bbox, sizeof(bbox));
+	bool reusable = true;
+
 	// remove the polyobj from each blockmap section
 	for(j = bbox[BOXBOTTOM]; j <= bbox[BOXTOP]; j++)
 	{
@@ -1090,16 +1083,21 @@ void FPolyObj::UnLinkPolyobj ()
 				link = PolyBlockMap[index+i];
 				while(link != NULL && link->polyobj != this)
 				{
+					// LinkPolyobj takes the first free slot, so it would not pick this one again.
+					if (link->polyobj == NULL) reusable = false;
 					link = link->next;
 				}
 				if(link == NULL)
 				{ // polyobj not located in the link cell
+					reusable = false;
 					continue;
 				}
 				link->polyobj = NULL;
+				UnlinkedSlots.Push(link);
 			}
 		}
 	}
+	UnlinkedGeneration = reusable ? LinkGeneration : -1;
 }
 
 //==========================================================================
@@ -1235,6 +1233,81 @@ bool FPolyObj::CheckMobjBlocking (side_t *sd)
 	return blocked;
 }
 
+//==========================================================================
+//
+// CheckMobjsBlocking
+//
+// Runs CheckMobjBlocking for every side, in order. Most of the time a
+// moving polyobject touches nothing, so the things that could be in its
+// way are collected once for the whole polyobject, and sides none of them
+// reach are not checked at all. After the first blocking side everything
+// is checked again, because thrusting may have moved, killed or spawned
+// actors.
+//
+//==========================================================================
+
+bool FPolyObj::CheckMobjsBlocking ()
+{
+	static TArray<AActor *> candidates;
+	bool blocked = false;
+	bool filter = bHasPortals == 0 && Sidedefs.Size() > 0;
+
+	candidates.Clear();
+	if (filter)
+	{
+		FBoundingBox box;
+		for (unsigned i = 0; i < Sidedefs.Size(); i++)
+		{
+			line_t *ld = Sidedefs[i]->linedef;
+			box.AddToBox(DVector2(ld->bbox[BOXLEFT], ld->bbox[BOXBOTTOM]));
+			box.AddToBox(DVector2(ld->bbox[BOXRIGHT], ld->bbox[BOXTOP]));
+		}
+		int bmapwidth = level.blockmap.bmapwidth;
+		int bmapheight = level.blockmap.bmapheight;
+		int top = clamp(level.blockmap.GetBlockY(box.Top()), 0, bmapheight - 1);
+		int bottom = clamp(level.blockmap.GetBlockY(box.Bottom()), 0, bmapheight - 1);
+		int left = clamp(level.blockmap.GetBlockX(box.Left()), 0, bmapwidth - 1);
+		int right = clamp(level.blockmap.GetBlockX(box.Right()), 0, bmapwidth - 1);
+
+		FBlockThingsIterator it(left, bottom, right, top);
+		AActor *mobj;
+		while ((mobj = it.Next()) != NULL)
+		{
+			if ((mobj->flags&MF_SOLID) && !(mobj->flags&MF_NOCLIP))
+			{
+				candidates.Push(mobj);
+			}
+		}
+	}
+
+	for (unsigned i = 0; i < Sidedefs.Size(); i++)
+	{
+		side_t *sd = Sidedefs[i];
+		if (filter)
+		{
+			line_t *ld = sd->linedef;
+			unsigned j;
+			for (j = 0; j < candidates.Size(); j++)
+			{
+				AActor *mobj = candidates[j];
+				DVector2 pos = mobj->PosRelative(ld);
+				FBoundingBox box(pos.X, pos.Y, mobj->radius);
+				if (box.inRange(ld)) break;
+			}
+			if (j == candidates.Size())
+			{
+				continue;
+			}
+		}
+		if (CheckMobjBlocking(sd))
+		{
+			blocked = true;
+			filter = false;
+		}
+	}
+	return blocked;
+}
+
 //==========================================================================
 //
 // LinkPolyobj
@@ -1248,6 +1321,8 @@ void FPolyObj::LinkPolyobj ()
 	int bmapwidth = level.blockmap.bmapwidth;
 	int bmapheight = level.blockmap.bmapheight;
 
+	LinkGeneration++;
+
 	// calculate the polyobj bbox
 	Bounds.ClearBox();
 	for(unsigned i = 0; i < Sidedefs.Size(); i++)
@@ -1263,6 +1338,21 @@ void FPolyObj::LinkPolyobj ()
 	bbox[BOXLEFT] = level.blockmap.GetBlockX(Bounds.Left());
 	bbox[BOXTOP] = level.blockmap.GetBlockY(Bounds.Top());
 	bbox[BOXBOTTOM] = level.blockmap.GetBlockY(Bounds.Bottom());
+
+	// If nothing else was linked or unlinked since this polyobject was taken
+	// out and it still covers the same blocks, the slots it left are exactly
+	// the ones the search below would find.
+	bool reuse = UnlinkedGeneration == LinkGeneration - 1 && !memcmp(bbox, UnlinkedBBox, sizeof(bbox));
+	UnlinkedGeneration = -1;
+	if (reuse)
+	{
+		for (auto slot : UnlinkedSlots)
+		{
+			slot->polyobj = this;
+		}
+		return;
+	}
+
 	// add the polyobj to each blockmap section
 	for(int j = bbox[BOXBOTTOM]*bmapwidth; j <= bbox[BOXTOP]*bmapwidth;
 		j += bmapwidth)
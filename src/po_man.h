@@ -64,6 +64,7 @@ struct FPolyNode
 };
 
 // ===== Polyobj data =====
+struct polyblock_t;
 struct FPolyObj
 {
 	TArray<side_t *>		Sidedefs;
@@ -91,6 +92,12 @@ struct FPolyObj
 	TObjPtr<DPolyAction*> specialdata;	// pointer to a thinker, if the poly is moving
 	TObjPtr<DInterpolation*> interpolation;
 
+	// Where UnLinkPolyobj found this polyobject, so that LinkPolyobj can put
+	// it back into the same slots if it still covers the same blocks.
+	TArray<polyblock_t *> UnlinkedSlots;
+	int			UnlinkedBBox[4];
+	int			UnlinkedGeneration;	// LinkGeneration after the unlink, -1 if the slots can't be reused
+
 	FPolyObj();
 	DInterpolation *SetInterpolation();
 	void StopInterpolation();
@@ -100,6 +107,7 @@ struct FPolyObj
 	bool RotatePolyobj (DAngle angle, bool fromsave = false);
 	void ClosestPoint(const DVector2 &fpos, DVector2 &out, side_t **side) const;
 	void LinkPolyobj ();
+	static int LinkGeneration;	// changes whenever any polyobject is linked or unlinked
 	void RecalcActorFloorCeil(FBoundingBox bounds) const;
 	void CreateSubsectorLinks();
 	void ClearSubsectorLinks();
@@ -114,6 +122,7 @@ private:
 	void DoMovePolyobj (const DVector2 &pos);
 	void UnLinkPolyobj ();
 	bool CheckMobjBlocking (side_t *sd);
+	bool CheckMobjsBlocking ();
 
 };
 extern FPolyObj *polyobjs;		// list of all poly-objects on the level
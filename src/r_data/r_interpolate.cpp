@@ -65,7 +65,7 @@ public:
 	void OnDestroy() override;
 	void UpdateInterpolation();
 	void Restore();
-	void Interpolate(double smoothratio);
+	bool Interpolate(double smoothratio);
 	
 	virtual void Serialize(FSerializer &arc);
 	size_t PropagateMark();
@@ -93,7 +93,7 @@ public:
 	void OnDestroy() override;
 	void UpdateInterpolation();
 	void Restore();
-	void Interpolate(double smoothratio);
+	bool Interpolate(double smoothratio);
 	
 	virtual void Serialize(FSerializer &arc);
 };
@@ -121,7 +121,7 @@ public:
 	void OnDestroy() override;
 	void UpdateInterpolation();
 	void Restore();
-	void Interpolate(double smoothratio);
+	bool Interpolate(double smoothratio);
 	
 	virtual void Serialize(FSerializer &arc);
 };
@@ -148,7 +148,7 @@ public:
 	void OnDestroy() override;
 	void UpdateInterpolation();
 	void Restore();
-	void Interpolate(double smoothratio);
+	bool Interpolate(double smoothratio);
 	
 	virtual void Serialize(FSerializer &arc);
 };
@@ -246,9 +246,12 @@ void FInterpolator::RemoveInterpolation(DInterpolation *interp)
 		if (interp->Prev != NULL) interp->Prev->Next = interp->Next;
 		if (interp->Next != NULL) interp->Next->Prev = interp->Prev;
 	}
-		interp->Next = nullptr;
-		interp->Prev = nullptr;
-		count--;
+	interp->Next = nullptr;
+	interp->Prev = nullptr;
+	count--;
+
+	auto index = Interpolated.Find(interp);
+	if (index < Interpolated.Size()) Interpolated.Delete(index);
 }
 
 //==========================================================================
@@ -259,19 +262,20 @@ void FInterpolator::RemoveInterpolation(DInterpolation *interp)
 
 void FInterpolator::DoInterpolations(double smoothratio)
 {
+	Interpolated.Clear();
 	if (smoothratio >= 1.)
 	{
-		didInterp = false;
 		return;
 	}
 
-	didInterp = true;
-
 	DInterpolation *probe = Head;
 	while (probe != NULL)
 	{
 		DInterpolation *next = probe->Next;
-		probe->Interpolate(smoothratio);
+		if (probe->Interpolate(smoothratio))
+		{
+			Interpolated.Push(probe);
+		}
 		probe = next;
 	}
 }
@@ -284,14 +288,12 @@ void FInterpolator::DoInterpolations(double smoothratio)
 
 void FInterpolator::RestoreInterpolations()
 {
-	if (didInterp)
+	// Only the interpolations that changed something need to be undone.
+	for (auto probe : Interpolated)
 	{
-		didInterp = false;
-		for (DInterpolation *probe = Head; probe != NULL; probe = probe->Next)
-		{
-			probe->Restore();
-		}
+		probe->Restore();
 	}
+	Interpolated.Clear();
 }
 
 //==========================================================================
@@ -304,6 +306,7 @@ void FInterpolator::ClearInterpolations()
 {
 	DInterpolation *probe = Head;
 	Head = nullptr;
+	Interpolated.Clear();
 	while (probe != nullptr)
 	{
 		DInterpolation *next = probe->Next;
@@ -487,7 +490,7 @@ void DSectorPlaneInterpolation::Restore()
 //
 //==========================================================================
 
-void DSectorPlaneInterpolation::Interpolate(double smoothratio)
+bool DSectorPlaneInterpolation::Interpolate(double smoothratio)
 {
 	secplane_t *pplane;
 	int pos;
@@ -510,13 +513,15 @@ void DSectorPlaneInterpolation::Interpolate(double smoothratio)
 	{
 		Destroy();
 	}
-	else
+	else if (oldheight != bakheight || oldtexz != baktexz)
 	{
 		pplane->setD(oldheight + (bakheight - oldheight) * smoothratio);
 		sector->SetPlaneTexZ(pos, oldtexz + (baktexz - oldtexz) * smoothratio, true);
-	P_RecalculateAttached3DFloors(sector);
+		P_RecalculateAttached3DFloors(sector);
 		sector->CheckPortalPlane(pos);
+		return true;
 	}
+	return false;
 }
 
 //==========================================================================
@@ -624,20 +629,19 @@ void DSectorScrollInterpolation::Restore()
 //
 //==========================================================================
 
-void DSectorScrollInterpolation::Interpolate(double smoothratio)
+bool DSectorScrollInterpolation::Interpolate(double smoothratio)
 {
 	bakx = sector->GetXOffset(ceiling);
 	baky = sector->GetYOffset(ceiling, false);
 
-	if (refcount == 0 && oldx == bakx && oldy == baky)
+	if (oldx == bakx && oldy == baky)
 	{
-		Destroy();
-	}
-	else
-	{
-		sector->SetXOffset(ceiling, oldx + (bakx - oldx) * smoothratio);
-		sector->SetYOffset(ceiling, oldy + (baky - oldy) * smoothratio);
+		if (refcount == 0) Destroy();
+		return false;
 	}
+	sector->SetXOffset(ceiling, oldx + (bakx - oldx) * smoothratio);
+	sector->SetYOffset(ceiling, oldy + (baky - oldy) * smoothratio);
+	return true;
 }
 
 //==========================================================================
@@ -722,20 +726,19 @@ void DWallScrollInterpolation::Restore()
 //
 //==========================================================================
 
-void DWallScrollInterpolation::Interpolate(double smoothratio)
+bool DWallScrollInterpolation::Interpolate(double smoothratio)
 {
 	bakx = side->GetTextureXOffset(part);
 	baky = side->GetTextureYOffset(part);
 
-	if (refcount == 0 && oldx == bakx && oldy == baky)
-	{
-		Destroy();
-	}
-	else
+	if (oldx == bakx && oldy == baky)
 	{
-		side->SetTextureXOffset(part, oldx + (bakx - oldx) * smoothratio);
-		side->SetTextureYOffset(part, oldy + (baky - oldy) * smoothratio);
+		if (refcount == 0) Destroy();
+		return false;
 	}
+	side->SetTextureXOffset(part, oldx + (bakx - oldx) * smoothratio);
+	side->SetTextureYOffset(part, oldy + (baky - oldy) * smoothratio);
+	return true;
 }
 
 //==========================================================================
@@ -829,7 +832,7 @@ void DPolyobjInterpolation::Restore()
 //
 //==========================================================================
 
-void DPolyobjInterpolation::Interpolate(double smoothratio)
+bool DPolyobjInterpolation::Interpolate(double smoothratio)
 {
 	bool changed = false;
 	for(unsigned int i = 0; i < poly->Vertices.Size(); i++)
@@ -848,16 +851,20 @@ void DPolyobjInterpolation::Interpolate(double smoothratio)
 	if (refcount == 0 && !changed)
 	{
 		Destroy();
+		return false;
 	}
-	else
+	bakcx = poly->CenterSpot.pos.X;
+	bakcy = poly->CenterSpot.pos.Y;
+	if (!changed && bakcx == oldcx && bakcy == oldcy)
 	{
-		bakcx = poly->CenterSpot.pos.X;
-		bakcy = poly->CenterSpot.pos.Y;
-		poly->CenterSpot.pos.X = bakcx + (bakcx - oldcx) * smoothratio;
-		poly->CenterSpot.pos.Y = bakcy + (bakcy - oldcy) * smoothratio;
-
-		poly->ClearSubsectorLinks();
+		// Nothing is moving right now so the live data can be rendered as is.
+		return false;
 	}
+	poly->CenterSpot.pos.X = bakcx + (bakcx - oldcx) * smoothratio;
+	poly->CenterSpot.pos.Y = bakcy + (bakcy - oldcy) * smoothratio;
+
+	poly->ClearSubsectorLinks();
+	return true;
 }
 
 //==========================================================================
@@ -30,7 +30,8 @@ public:
 	void OnDestroy() override;
 	virtual void UpdateInterpolation() = 0;
 	virtual void Restore() = 0;
-	virtual void Interpolate(double smoothratio) = 0;
+	// Returns false if nothing had to be changed, so that no Restore is needed.
+	virtual bool Interpolate(double smoothratio) = 0;
 	
 	virtual void Serialize(FSerializer &arc);
 };
@@ -44,7 +45,7 @@ public:
 struct FInterpolator
 {
 	TObjPtr<DInterpolation*> Head;
-	bool didInterp;
+	TArray<DInterpolation*> Interpolated;	// the ones that need to be restored after rendering
 	int count;
 
 	int CountInterpolations ();
@@ -53,7 +54,6 @@ public:
 	FInterpolator()
 	{
 		Head = nullptr;
-		didInterp = false;
 		count = 0;
 	}
 	void UpdateInterpolations();
@@ -240,6 +240,134 @@ DEFINE_ACTION_FUNCTION_NATIVE(DBlockThingsIterator, Next, NextBTI)
 	ACTION_RETURN_BOOL(NextBTI(self));
 }
 
+//===========================================================================
+//
+// scriptable radius query
+//
+// Unlike BlockThingsIterator this collects everything up front, so
+// every thing is only returned once and the results can be sorted
+// by distance.
+//
+//===========================================================================
+
+class DRadiusThingsIterator : public DObject
+{
+	DECLARE_ABSTRACT_CLASS(DRadiusThingsIterator, DObject);
+	TArray<FRadiusThing> results;
+	unsigned index;
+
+public:
+	FRadiusThing cres;
+
+	DRadiusThingsIterator(const DVector3 &pos, double radius, int flags, sector_t *sec)
+	{
+		P_GetThingsInRadius(results, pos, radius, sec, flags);
+		Reinit();
+	}
+
+	bool Next()
+	{
+		while (index < results.Size())
+		{
+			// Things that got destroyed in the meantime have been cleared by PropagateMark,
+			// but ones destroyed since the last collection are only marked for deletion.
+			cres = results[index++];
+			if (cres.thing != nullptr && !(cres.thing->ObjectFlags & OF_EuthanizeMe)) return true;
+		}
+		cres.thing = nullptr;
+		return false;
+	}
+
+	void Reinit()
+	{
+		index = 0;
+		cres.thing = nullptr;
+		cres.Position.Zero();
+		cres.Distance = 0;
+		cres.portalflags = 0;
+	}
+
+	// The number of things found when the iterator was created. This
+	// includes things that have been destroyed since, which Next skips.
+	int Count() const
+	{
+		return results.Size();
+	}
+
+	size_t PropagateMark()
+	{
+		for (auto &r : results) GC::Mark(r.thing);
+		GC::Mark(cres.thing);
+		return results.Size() * sizeof(FRadiusThing) + Super::PropagateMark();
+	}
+};
+
+IMPLEMENT_CLASS(DRadiusThingsIterator, true, false);
+
+static DRadiusThingsIterator *CreateRTI(AActor *origin, double radius, int flags)
+{
+	return Create<DRadiusThingsIterator>(origin->Pos(), radius, flags, origin->Sector);
+}
+
+DEFINE_ACTION_FUNCTION_NATIVE(DRadiusThingsIterator, Create, CreateRTI)
+{
+	PARAM_PROLOGUE;
+	PARAM_OBJECT_NOT_NULL(origin, AActor);
+	PARAM_FLOAT(radius);
+	PARAM_INT(flags);
+	ACTION_RETURN_OBJECT(CreateRTI(origin, radius, flags));
+}
+
+static DRadiusThingsIterator *CreateRTIFromPos(double x, double y, double z, double radius, int flags, sector_t *sec)
+{
+	return Create<DRadiusThingsIterator>(DVector3(x, y, z), radius, flags, sec);
+}
+
+DEFINE_ACTION_FUNCTION_NATIVE(DRadiusThingsIterator, CreateFromPos, CreateRTIFromPos)
+{
+	PARAM_PROLOGUE;
+	PARAM_FLOAT(x);
+	PARAM_FLOAT(y);
+	PARAM_FLOAT(z);
+	PARAM_FLOAT(radius);
+	PARAM_INT(flags);
+	PARAM_POINTER(sec, sector_t);
+	ACTION_RETURN_OBJECT(CreateRTIFromPos(x, y, z, radius, flags, sec));
+}
+
+static int NextRTI(DRadiusThingsIterator *self)
+{
+	return self->Next();
+}
+
+DEFINE_ACTION_FUNCTION_NATIVE(DRadiusThingsIterator, Next, NextRTI)
+{
+	PARAM_SELF_PROLOGUE(DRadiusThingsIterator);
+	ACTION_RETURN_BOOL(NextRTI(self));
+}
+
+static void ReinitRTI(DRadiusThingsIterator *self)
+{
+	self->Reinit();
+}
+
+DEFINE_ACTION_FUNCTION_NATIVE(DRadiusThingsIterator, Reinit, ReinitRTI)
+{
+	PARAM_SELF_PROLOGUE(DRadiusThingsIterator);
+	self->Reinit();
+	return 0;
+}
+
+static int CountRTI(DRadiusThingsIterator *self)
+{
+	return self->Count();
+}
+
+DEFINE_ACTION_FUNCTION_NATIVE(DRadiusThingsIterator, Count, CountRTI)
+{
+	PARAM_SELF_PROLOGUE(DRadiusThingsIterator);
+	ACTION_RETURN_INT(self->Count());
+}
 
 class DSectorTagIterator : public DObject, public FSectorTagIterator
 {
@@ -395,3 +523,8 @@ DEFINE_FIELD_NAMED(DBlockLinesIterator, cres.portalflags, portalflags);
 DEFINE_FIELD_NAMED(DBlockThingsIterator, cres.thing, thing);
 DEFINE_FIELD_NAMED(DBlockThingsIterator, cres.Position, position);
 DEFINE_FIELD_NAMED(DBlockThingsIterator, cres.portalflags, portalflags);
+
+DEFINE_FIELD_NAMED(DRadiusThingsIterator, cres.thing, thing);
+DEFINE_FIELD_NAMED(DRadiusThingsIterator, cres.Position, position);
+DEFINE_FIELD_NAMED(DRadiusThingsIterator, cres.Distance, distance);
+DEFINE_FIELD_NAMED(DRadiusThingsIterator, cres.portalflags, portalflags);
@@ -36,6 +36,7 @@
 #include <stdlib.h>
 
 #include "oalsound.h"
+#include "softsound.h"
 
 #include "i_module.h"
 #include "cmdlib.h"
@@ -63,6 +64,10 @@ CVAR (Int, snd_hrtf, 0, CVAR_ARCHIVE|CVAR_GLOBALCONFIG)
 
 CVAR(String, snd_backend, DEF_BACKEND, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
 
+// Output file for the "wav" backend. The "soft" backend mixes the same way
+// but throws the result away.
+CVAR(String, snd_wavfile, "soundout.wav", CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+
 // killough 2/21/98: optionally use varying pitched sounds
 CVAR (Bool, snd_pitched, false, CVAR_ARCHIVE)
 
@@ -256,11 +261,27 @@ void I_InitSound ()
 		return;
 	}
 
-	// Keep it simple: let everything except "null" init the sound.
-	if (stricmp(snd_backend, "null") == 0)
+	// -wavout <file> captures everything to a WAV file, regardless of snd_backend.
+	const char *wavout = Args->CheckValue("-wavout");
+
+	// "null", "soft" and "wav" pick their backend by name. Anything else
+	// uses OpenAL if it is available.
+	if (wavout != nullptr)
+	{
+		GSnd = new SoftSoundRenderer(wavout);
+	}
+	else if (stricmp(snd_backend, "null") == 0)
 	{
 		GSnd = new NullSoundRenderer;
 	}
+	else if (stricmp(snd_backend, "soft") == 0)
+	{
+		GSnd = new SoftSoundRenderer(nullptr);
+	}
+	else if (stricmp(snd_backend, "wav") == 0)
+	{
+		GSnd = new SoftSoundRenderer(snd_wavfile);
+	}
 	else
 	{
 		#ifndef NO_OPENAL
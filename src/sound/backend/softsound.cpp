@@ -0,0 +1,1053 @@
+/*
+** softsound.cpp
+** Software mixing sound renderer with WAV file or null output
+**
+**---------------------------------------------------------------------------
+**
+** Redistribution and use in source and binary forms, with or without
+** modification, are permitted provided that the following conditions
+** are met:
+**
+** 1. Redistributions of source code must retain the above copyright
+**    notice, this list of conditions and the following disclaimer.
+** 2. Redistributions in binary form must reproduce the above copyright
+**    notice, this list of conditions and the following disclaimer in the
+**    documentation and/or other materials provided with the distribution.
+** 3. The name of the author may not be used to endorse or promote products
+**    derived from this software without specific prior written permission.
+**
+** THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+** IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+** OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+** IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+** INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+** NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+** DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+** THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+** (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+** THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+**---------------------------------------------------------------------------
+**
+** All mixing happens on the calling thread inside UpdateSounds, based on
+** how much real time has passed since the last call. Voices are resampled
+** with linear interpolation into a float buffer, then panned and added to
+** the stereo mix buffer in one SIMD pass per voice.
+*/
+
+#include <math.h>
+#include <chrono>
+
+#ifndef NO_SSE
+#include <emmintrin.h>
+#endif
+
+#include "softsound.h"
+#include "c_cvars.h"
+#include "templates.h"
+#include "v_text.h"
+#include "files.h"
+#include "m_swap.h"
+#include "i_time.h"
+#include "cmdlib.h"
+#include "xs_Float.h"
+
+EXTERN_CVAR (Int, snd_channels)
+EXTERN_CVAR (Int, snd_samplerate)
+EXTERN_CVAR (Bool, snd_pitched)
+
+#define AREA_SOUND_RADIUS  (32.f)
+
+#define PITCH_MULT (0.7937005f) /* Approx. 4 semitones lower; what Nash suggested */
+
+#define PITCH(pitch) (snd_pitched ? (pitch)/128.f : 1.f)
+
+const char *GetSampleTypeName(SampleType type);
+const char *GetChannelConfigName(ChannelConfig chan);
+
+//==========================================================================
+//
+// Sample data is stored as 16 bit PCM, regardless of the source format.
+//
+//==========================================================================
+
+struct SoftSample
+{
+	TArray<int16_t> Data;
+	int Channels;
+	int Rate;
+	uint32_t Frames;
+	uint32_t LoopStart;
+	uint32_t LoopEnd;
+};
+
+struct SoftVoice
+{
+	SoftSample *Sample;
+	FISoundChannel *Chan;
+	uint64_t Pos;			// 32.32 fixed point, in sample frames
+	uint64_t Step;
+	float Volume;
+	float Pitch;
+	float GainL, GainR;
+	bool Loop;
+	bool Pausable;
+	bool NoReverb;
+	bool Is3D;
+	bool Area;
+	bool Finished;
+	FVector3 Position;
+	FRolloffInfo Rolloff;
+	float DistScale;
+};
+
+//==========================================================================
+//
+// SoftSoundStream
+//
+// Pulls data from its callback whenever the mixer needs more and keeps it
+// as float stereo until it has been resampled into the mix.
+//
+//==========================================================================
+
+class SoftSoundStream : public SoundStream
+{
+	friend class SoftSoundRenderer;
+
+	SoftSoundRenderer *Renderer;
+	SoundStreamCallback Callback;
+	void *UserData;
+	int Flags;
+	int SampleRate;
+	int FrameSize;
+	TArray<uint8_t> Data;
+	TArray<float> Pending;		// interleaved stereo
+	unsigned PendingPos;		// first frame of Pending that's still needed
+	uint64_t Frac;				// 0.32 fixed point position between frames
+	float Volume;
+	bool Playing;
+	bool Paused;
+
+public:
+	SoftSoundStream(SoftSoundRenderer *renderer)
+		: Renderer(renderer), Callback(nullptr), UserData(nullptr), Flags(0), SampleRate(0), FrameSize(0),
+		  PendingPos(0), Frac(0), Volume(1.f), Playing(false), Paused(false)
+	{
+		Renderer->Streams.Push(this);
+	}
+
+	~SoftSoundStream()
+	{
+		if (Renderer == nullptr) return;
+		unsigned idx = Renderer->Streams.Find(this);
+		if (idx < Renderer->Streams.Size())
+			Renderer->Streams.Delete(idx);
+	}
+
+	bool Init(SoundStreamCallback callback, int buffbytes, int flags, int samplerate, void *userdata)
+	{
+		Callback = callback;
+		UserData = userdata;
+		Flags = flags;
+		SampleRate = samplerate;
+
+		FrameSize = (flags & Bits8) ? 1 : (flags & (Bits32 | Float)) ? 4 : 2;
+		if (!(flags & Mono)) FrameSize *= 2;
+
+		if (samplerate <= 0 || ((flags & Bits32) && !(flags & Float)))
+		{
+			Printf("Unsupported format: 0x%x\n", flags);
+			return false;
+		}
+
+		buffbytes += FrameSize - 1;
+		buffbytes -= buffbytes % FrameSize;
+		Data.Resize(buffbytes);
+		return true;
+	}
+
+	bool Play(bool looping, float vol)
+	{
+		Volume = vol;
+		Playing = true;
+		Paused = false;
+		return true;
+	}
+
+	void Stop()
+	{
+		Playing = false;
+		Pending.Clear();
+		PendingPos = 0;
+		Frac = 0;
+	}
+
+	void SetVolume(float vol)
+	{
+		Volume = vol;
+	}
+
+	bool SetPaused(bool paused)
+	{
+		Paused = paused;
+		return true;
+	}
+
+	bool IsEnded()
+	{
+		return !Playing;
+	}
+
+	FString GetStats()
+	{
+		FString stats;
+		stats.Format("%s, %d hz, " TEXTCOLOR_YELLOW "%u" TEXTCOLOR_NORMAL " frames buffered",
+			Playing ? (Paused ? "paused" : "playing") : "stopped", SampleRate, Pending.Size() / 2 - PendingPos);
+		return stats;
+	}
+
+private:
+	// Converts one more buffer from the callback into float stereo.
+	bool Fill()
+	{
+		if (!Callback(this, &Data[0], Data.Size(), UserData))
+		{
+			return false;
+		}
+
+		unsigned frames = Data.Size() / FrameSize;
+		unsigned chans = (Flags & Mono) ? 1 : 2;
+		unsigned ofs = Pending.Reserve(frames * 2);
+		float *out = &Pending[ofs];
+
+		for (unsigned i = 0; i < frames * chans; i++)
+		{
+			float s;
+			if (Flags & Bits8) s = (Data[i] - 128) * (1.f / 128);
+			else if (Flags & Float) s = ((float *)&Data[0])[i];
+			else s = ((int16_t *)&Data[0])[i] * (1.f / 32768);
+
+			if (chans == 1) out[i * 2] = out[i * 2 + 1] = s;
+			else out[i] = s;
+		}
+		return true;
+	}
+};
+
+//==========================================================================
+//
+// SoftSoundRenderer
+//
+//==========================================================================
+
+SoftSoundRenderer::SoftSoundRenderer(const char *wavfile)
+{
+	OutputRate = snd_samplerate > 0 ? *snd_samplerate : 44100;
+	SfxVolume = 1.f;
+	MusicVolume = 1.f;
+	SFXPaused = 0;
+	SyncPaused = false;
+	WasInWater = false;
+	Inactive = INACTIVE_Active;
+	Listener = SoundListener();
+
+	int numvoices = std::max<int>(snd_channels, 2);
+	Voices.Resize(numvoices);
+	FreeVoices.Grow(numvoices);
+	for (int i = numvoices - 1; i >= 0; i--)
+	{
+		Voices[i] = SoftVoice();
+		FreeVoices.Push(&Voices[i]);
+	}
+
+	MixBuffer.Resize(MIXBLOCK * 2);
+	VoiceBuffer.Resize(MIXBLOCK * 2);
+	OutBuffer.Resize(MIXBLOCK * 2);
+
+	WavFile = nullptr;
+	WavBytes = 0;
+	if (wavfile != nullptr && *wavfile != 0)
+	{
+		WavName = wavfile;
+		FixPathSeperator(WavName);
+		WavFile = FileWriter::Open(WavName);
+		if (WavFile != nullptr)
+		{
+			// Write a 16 bit stereo PCM header. The sizes get fixed up on close.
+			uint8_t header[44];
+			memcpy(header, "RIFF\0\0\0\0WAVEfmt \x10\0\0\0\x01\0\x02\0", 24);
+			uint32_t rate = LittleLong(uint32_t(OutputRate));
+			uint32_t bytespersec = LittleLong(uint32_t(OutputRate * 4));
+			memcpy(header + 24, &rate, 4);
+			memcpy(header + 28, &bytespersec, 4);
+			memcpy(header + 32, "\x04\0\x10\0data\0\0\0\0", 12);
+			if (WavFile->Write(header, 44) != 44)
+			{
+				delete WavFile;
+				WavFile = nullptr;
+			}
+		}
+		if (WavFile == nullptr)
+		{
+			Printf(TEXTCOLOR_RED "Could not open %s for writing\n", WavName.GetChars());
+		}
+	}
+
+	LastUpdate = 0;
+	FramesMixed = 0;
+	MixTime.Reset();
+	LastMixMS = 0;
+	PeakVoices = 0;
+}
+
+SoftSoundRenderer::~SoftSoundRenderer()
+{
+	while (Streams.Size() > 0)
+	{
+		// Streams are owned by the music code, which has to be gone by now.
+		Streams[0]->Renderer = nullptr;
+		Streams.Delete(0);
+	}
+
+	if (WavFile != nullptr)
+	{
+		uint32_t size = LittleLong(WavBytes + 36);
+		WavFile->Seek(4, SEEK_SET);
+		WavFile->Write(&size, 4);
+		size = LittleLong(WavBytes);
+		WavFile->Seek(40, SEEK_SET);
+		WavFile->Write(&size, 4);
+		delete WavFile;
+		Printf("Wrote %.1f seconds of audio to %s\n", WavBytes / 4. / OutputRate, WavName.GetChars());
+	}
+}
+
+bool SoftSoundRenderer::IsValid()
+{
+	return WavName.IsEmpty() || WavFile != nullptr;
+}
+
+void SoftSoundRenderer::SetSfxVolume(float volume)
+{
+	SfxVolume = volume;
+	for (auto voice : ActiveVoices)
+	{
+		UpdateVoiceGains(voice);
+	}
+}
+
+void SoftSoundRenderer::SetMusicVolume(float volume)
+{
+	MusicVolume = volume;
+}
+
+float SoftSoundRenderer::GetOutputRate()
+{
+	return (float)OutputRate;
+}
+
+unsigned int SoftSoundRenderer::GetMSLength(SoundHandle sfx)
+{
+	SoftSample *sample = (SoftSample *)sfx.data;
+	if (sample == nullptr) return 0;
+	return (unsigned int)(sample->Frames * 1000. / sample->Rate);
+}
+
+unsigned int SoftSoundRenderer::GetSampleLength(SoundHandle sfx)
+{
+	SoftSample *sample = (SoftSample *)sfx.data;
+	return sample != nullptr ? sample->Frames : 0;
+}
+
+//==========================================================================
+//
+// SoftSoundRenderer :: LoadSoundRaw
+//
+//==========================================================================
+
+SoundHandle SoftSoundRenderer::LoadSoundRaw(uint8_t *sfxdata, int length, int frequency, int channels, int bits, int loopstart, int loopend)
+{
+	SoundHandle retval = { NULL };
+
+	if (length == 0) return retval;
+
+	if ((bits != 8 && bits != -8 && bits != 16) || (channels != 1 && channels != 2) || frequency <= 0)
+	{
+		Printf("Unhandled format: %d bit, %d channel, %d hz\n", bits, channels, frequency);
+		return retval;
+	}
+
+	int samplesize = abs(bits) / 8;
+	unsigned frames = length / (samplesize * channels);
+	if (frames == 0) return retval;
+
+	SoftSample *sample = new SoftSample;
+	sample->Channels = channels;
+	sample->Rate = frequency;
+	sample->Frames = frames;
+	sample->Data.Resize(frames * channels);
+
+	for (unsigned i = 0; i < frames * channels; i++)
+	{
+		if (bits == 16) sample->Data[i] = LittleShort(((int16_t *)sfxdata)[i]);
+		else if (bits == 8) sample->Data[i] = int16_t((sfxdata[i] - 128) << 8);
+		else sample->Data[i] = int16_t(int8_t(sfxdata[i]) << 8);
+	}
+
+	if (loopstart < 0) loopstart = 0;
+	if (loopend < loopstart || (unsigned)loopend > frames) loopend = frames;
+	sample->LoopStart = (unsigned)loopstart < frames ? loopstart : 0;
+	sample->LoopEnd = loopend > 0 ? loopend : frames;
+
+	retval.data = sample;
+	return retval;
+}
+
+//==========================================================================
+//
+// SoftSoundRenderer :: LoadSound
+//
+//==========================================================================
+
+SoundHandle SoftSoundRenderer::LoadSound(uint8_t *sfxdata, int length)
+{
+	SoundHandle retval = { NULL };
+	ChannelConfig chans;
+	SampleType type;
+	int srate;
+	uint32_t loop_start = 0, loop_end = ~0u;
+	bool startass = false, endass = false;
+
+	FindLoopTags(sfxdata, length, &loop_start, &startass, &loop_end, &endass);
+	auto decoder = CreateDecoder(sfxdata, length, true);
+	if (!decoder)
+		return retval;
+
+	SoundDecoder_GetInfo(decoder, &srate, &chans, &type);
+	if ((chans != ChannelConfig_Mono && chans != ChannelConfig_Stereo) ||
+		(type != SampleType_UInt8 && type != SampleType_Int16))
+	{
+		SoundDecoder_Close(decoder);
+		Printf("Unsupported audio format: %s, %s\n", GetChannelConfigName(chans),
+			GetSampleTypeName(type));
+		return retval;
+	}
+
+	TArray<uint8_t> data;
+	unsigned total = 0;
+	unsigned got;
+
+	data.Resize(32768);
+	while ((got = (unsigned)SoundDecoder_Read(decoder, (char*)&data[total], data.Size() - total)) > 0)
+	{
+		total += got;
+		data.Resize(total * 2);
+	}
+	SoundDecoder_Close(decoder);
+	if (total == 0)
+	{
+		return retval;
+	}
+
+	int channels = chans == ChannelConfig_Stereo ? 2 : 1;
+	int bits = type == SampleType_Int16 ? 16 : 8;
+	uint32_t frames = total / (channels * bits / 8);
+
+	if (!startass) loop_start = Scale(loop_start, srate, 1000);
+	if (!endass && loop_end != ~0u) loop_end = Scale(loop_end, srate, 1000);
+	if (loop_start > frames) loop_start = 0;
+	if (loop_end > frames) loop_end = frames;
+
+	return LoadSoundRaw(&data[0], total, srate, channels, bits, loop_start, loop_end);
+}
+
+void SoftSoundRenderer::UnloadSound(SoundHandle sfx)
+{
+	SoftSample *sample = (SoftSample *)sfx.data;
+	if (sample == nullptr)
+		return;
+
+	for (unsigned i = ActiveVoices.Size(); i-- > 0; )
+	{
+		if (i < ActiveVoices.Size() && ActiveVoices[i]->Sample == sample)
+		{
+			StopChannel(ActiveVoices[i]->Chan);
+		}
+	}
+	delete sample;
+}
+
+SoundStream *SoftSoundRenderer::CreateStream(SoundStreamCallback callback, int buffbytes, int flags, int samplerate, void *userdata)
+{
+	SoftSoundStream *stream = new SoftSoundStream(this);
+	if (!stream->Init(callback, buffbytes, flags, samplerate, userdata))
+	{
+		delete stream;
+		return NULL;
+	}
+	return stream;
+}
+
+//==========================================================================
+//
+// Voice management
+//
+//==========================================================================
+
+FSoundChan *SoftSoundRenderer::FindLowestChannel()
+{
+	FSoundChan *schan = soundEngine->GetChannels();
+	FSoundChan *lowest = NULL;
+	while (schan)
+	{
+		if (schan->SysChannel != NULL)
+		{
+			if (!lowest || schan->Priority < lowest->Priority ||
+				(schan->Priority == lowest->Priority &&
+				schan->DistanceSqr > lowest->DistanceSqr))
+				lowest = schan;
+		}
+		schan = schan->NextChan;
+	}
+	return lowest;
+}
+
+SoftVoice *SoftSoundRenderer::AllocVoice(int priority, float dist_sqr)
+{
+	if (FreeVoices.Size() == 0)
+	{
+		FSoundChan *lowest = FindLowestChannel();
+		if (lowest != nullptr && (lowest->Priority < priority ||
+			(lowest->Priority == priority && lowest->DistanceSqr > dist_sqr)))
+		{
+			StopChannel(lowest);
+		}
+		if (FreeVoices.Size() == 0)
+			return nullptr;
+	}
+	SoftVoice *voice;
+	FreeVoices.Pop(voice);
+	*voice = SoftVoice();
+	return voice;
+}
+
+FISoundChannel *SoftSoundRenderer::StartVoice(SoftVoice *voice, SoftSample *sample, float vol, int pitch, int chanflags, FISoundChannel *reuse_chan, float startTime)
+{
+	voice->Sample = sample;
+	voice->Volume = vol;
+	voice->Pitch = PITCH(pitch);
+	voice->Loop = !!(chanflags & SNDF_LOOP);
+	voice->Pausable = !(chanflags & SNDF_NOPAUSE);
+	voice->NoReverb = !!(chanflags & SNDF_NOREVERB);
+	voice->Area = !!(chanflags & SNDF_AREA);
+
+	double offset;
+	if (!reuse_chan || reuse_chan->StartTime == 0)
+	{
+		offset = startTime * sample->Rate;
+	}
+	else if (chanflags & SNDF_ABSTIME)
+	{
+		offset = (double)reuse_chan->StartTime;
+	}
+	else
+	{
+		offset = std::chrono::duration_cast<std::chrono::duration<double>>(
+			std::chrono::steady_clock::now().time_since_epoch() -
+			std::chrono::steady_clock::time_point::duration(reuse_chan->StartTime)
+			).count() * sample->Rate;
+	}
+	uint64_t frame = offset > 0 ? uint64_t(offset) : 0;
+	if (frame >= sample->Frames)
+	{
+		frame = voice->Loop ? frame % sample->Frames : sample->Frames;
+	}
+	voice->Pos = frame << 32;
+	voice->Finished = frame >= sample->Frames;
+
+	FISoundChannel *chan = reuse_chan;
+	if (!chan) chan = soundEngine->GetChannel(voice);
+	else chan->SysChannel = voice;
+	voice->Chan = chan;
+	UpdateVoicePitch(voice);
+
+	ActiveVoices.Push(voice);
+	PeakVoices = std::max(PeakVoices, ActiveVoices.Size());
+	return chan;
+}
+
+FISoundChannel *SoftSoundRenderer::StartSound(SoundHandle sfx, float vol, int pitch, int chanflags, FISoundChannel *reuse_chan, float startTime)
+{
+	SoftSample *sample = (SoftSample *)sfx.data;
+	if (sample == nullptr)
+		return NULL;
+
+	SoftVoice *voice = AllocVoice(INT_MAX, 0.f);
+	if (voice == nullptr)
+		return NULL;
+
+	FISoundChannel *chan = StartVoice(voice, sample, vol, pitch, chanflags, reuse_chan, startTime);
+	UpdateVoiceGains(voice);
+
+	chan->Rolloff.RolloffType = ROLLOFF_Log;
+	chan->Rolloff.RolloffFactor = 0.f;
+	chan->Rolloff.MinDistance = 1.f;
+	chan->DistanceSqr = 0.f;
+	chan->ManualRolloff = false;
+	return chan;
+}
+
+FISoundChannel *SoftSoundRenderer::StartSound3D(SoundHandle sfx, SoundListener *listener, float vol,
+	FRolloffInfo *rolloff, float distscale, int pitch, int priority, const FVector3 &pos, const FVector3 &vel,
+	int channum, int chanflags, FISoundChannel *reuse_chan, float startTime)
+{
+	SoftSample *sample = (SoftSample *)sfx.data;
+	if (sample == nullptr)
+		return NULL;
+
+	float dist_sqr = (float)(pos - listener->position).LengthSquared();
+	SoftVoice *voice = AllocVoice(priority, dist_sqr);
+	if (voice == nullptr)
+		return NULL;
+
+	voice->Is3D = true;
+	voice->Position = pos;
+	voice->Rolloff = *rolloff;
+	voice->DistScale = distscale;
+
+	FISoundChannel *chan = StartVoice(voice, sample, vol, pitch, chanflags, reuse_chan, startTime);
+	UpdateVoiceGains(voice);
+
+	chan->Rolloff = *rolloff;
+	chan->DistanceSqr = dist_sqr;
+	chan->ManualRolloff = true;
+	return chan;
+}
+
+void SoftSoundRenderer::StopChannel(FISoundChannel *chan)
+{
+	if (chan == NULL || chan->SysChannel == NULL)
+		return;
+
+	SoftVoice *voice = (SoftVoice *)chan->SysChannel;
+	// Release first, so it can be properly marked as evicted if it's being killed
+	soundEngine->ChannelEnded(chan);
+
+	unsigned i = ActiveVoices.Find(voice);
+	if (i < ActiveVoices.Size())
+		ActiveVoices.Delete(i);
+
+	if (!(chan->ChanFlags & CHANF_EVICTED))
+		soundEngine->SoundDone(chan);
+
+	voice->Sample = nullptr;
+	voice->Chan = nullptr;
+	FreeVoices.Push(voice);
+}
+
+void SoftSoundRenderer::PurgeStoppedVoices()
+{
+	for (unsigned i = ActiveVoices.Size(); i-- > 0; )
+	{
+		if (i < ActiveVoices.Size() && ActiveVoices[i]->Finished)
+		{
+			StopChannel(ActiveVoices[i]->Chan);
+		}
+	}
+}
+
+void SoftSoundRenderer::ChannelVolume(FISoundChannel *chan, float volume)
+{
+	if (chan == NULL || chan->SysChannel == NULL)
+		return;
+
+	SoftVoice *voice = (SoftVoice *)chan->SysChannel;
+	voice->Volume = volume;
+	UpdateVoiceGains(voice);
+}
+
+void SoftSoundRenderer::ChannelPitch(FISoundChannel *chan, float pitch)
+{
+	if (chan == NULL || chan->SysChannel == NULL)
+		return;
+
+	SoftVoice *voice = (SoftVoice *)chan->SysChannel;
+	voice->Pitch = std::max(pitch, 0.0001f);
+	UpdateVoicePitch(voice);
+}
+
+unsigned int SoftSoundRenderer::GetPosition(FISoundChannel *chan)
+{
+	if (chan == NULL || chan->SysChannel == NULL)
+		return 0;
+
+	return (unsigned int)(((SoftVoice *)chan->SysChannel)->Pos >> 32);
+}
+
+void SoftSoundRenderer::MarkStartTime(FISoundChannel *chan, float startTime)
+{
+	using namespace std::chrono;
+	auto startTimeDuration = duration<double>(startTime);
+	auto diff = steady_clock::now().time_since_epoch() - startTimeDuration;
+	chan->StartTime = static_cast<uint64_t>(duration_cast<nanoseconds>(diff).count());
+}
+
+float SoftSoundRenderer::GetAudibility(FISoundChannel *chan)
+{
+	if (chan == NULL || chan->SysChannel == NULL)
+		return 0.f;
+
+	SoftVoice *voice = (SoftVoice *)chan->SysChannel;
+	return SfxVolume * voice->Volume * soundEngine->GetRolloff(&chan->Rolloff, sqrtf(chan->DistanceSqr) * chan->DistanceScale);
+}
+
+void SoftSoundRenderer::Sync(bool sync)
+{
+	SyncPaused = sync;
+}
+
+void SoftSoundRenderer::SetSfxPaused(bool paused, int slot)
+{
+	if (paused) SFXPaused |= 1 << slot;
+	else SFXPaused &= ~(1 << slot);
+}
+
+void SoftSoundRenderer::SetInactive(SoundRenderer::EInactiveState state)
+{
+	Inactive = state;
+}
+
+//==========================================================================
+//
+// Spatialization
+//
+//==========================================================================
+
+void SoftSoundRenderer::UpdateVoicePitch(SoftVoice *voice)
+{
+	float pitch = voice->Pitch;
+	if (WasInWater && !voice->NoReverb && !(voice->Chan != nullptr && (voice->Chan->ChanFlags & CHANF_UI)))
+		pitch *= PITCH_MULT;
+
+	voice->Step = uint64_t((double)voice->Sample->Rate * pitch / OutputRate * 4294967296.);
+	if (voice->Step == 0) voice->Step = 1;
+}
+
+void SoftSoundRenderer::UpdateVoiceGains(SoftVoice *voice)
+{
+	float gain = SfxVolume * voice->Volume;
+
+	if (!voice->Is3D)
+	{
+		// Stereo samples play unpanned; mono ones sit in the center.
+		voice->GainL = voice->GainR = voice->Sample->Channels == 2 ? gain : gain * 0.70710678f;
+		return;
+	}
+
+	FVector3 dir = voice->Position - Listener.position;
+	float dist = dir.Length();
+	gain *= soundEngine->GetRolloff(&voice->Rolloff, dist * voice->DistScale);
+
+	// Equal power panning. The sound code swaps Y and Z, so the horizontal
+	// plane is X/Z here.
+	float pan = 0;
+	if (dist > 0.0004f)
+	{
+		pan = (dir.X * sinf(Listener.angle) - dir.Z * cosf(Listener.angle)) / dist;
+		if (voice->Area && dist < AREA_SOUND_RADIUS)
+		{
+			pan *= dist / AREA_SOUND_RADIUS;
+		}
+	}
+	float angle = (clamp(pan, -1.f, 1.f) + 1.f) * float(M_PI / 4);
+	voice->GainL = gain * cosf(angle);
+	voice->GainR = gain * sinf(angle);
+}
+
+void SoftSoundRenderer::UpdateSoundParams3D(SoundListener *listener, FISoundChannel *chan, bool areasound, const FVector3 &pos, const FVector3 &vel)
+{
+	if (chan == NULL || chan->SysChannel == NULL)
+		return;
+
+	SoftVoice *voice = (SoftVoice *)chan->SysChannel;
+	chan->DistanceSqr = (float)(pos - listener->position).LengthSquared();
+	voice->Position = pos;
+	voice->Area = areasound;
+	UpdateVoiceGains(voice);
+}
+
+void SoftSoundRenderer::UpdateListener(SoundListener *listener)
+{
+	if (!listener->valid)
+		return;
+
+	Listener = *listener;
+
+	// No reverb here, but keep the pitch drop when going underwater
+	// consistent with the OpenAL backend.
+	bool inwater = listener->underwater || (listener->Environment != nullptr && listener->Environment->SoftwareWater);
+	bool changed = inwater != WasInWater;
+	WasInWater = inwater;
+
+	for (auto voice : ActiveVoices)
+	{
+		if (changed) UpdateVoicePitch(voice);
+		if (voice->Is3D) UpdateVoiceGains(voice);
+	}
+}
+
+//==========================================================================
+//
+// Mixing
+//
+//==========================================================================
+
+void SoftSoundRenderer::UpdateSounds()
+{
+	uint64_t now = I_nsTime();
+	if (LastUpdate == 0 || Inactive == INACTIVE_Complete)
+	{
+		LastUpdate = now;
+		return;
+	}
+
+	uint64_t frames = (now - LastUpdate) * OutputRate / 1000000000;
+	if (frames > uint64_t(OutputRate / 10))
+	{
+		// Don't try to catch up after a long stall.
+		frames = OutputRate / 10;
+		LastUpdate = now;
+	}
+	else
+	{
+		LastUpdate += frames * 1000000000 / OutputRate;
+	}
+
+	MixTime.Reset();
+	MixTime.Clock();
+	while (frames > 0)
+	{
+		int block = (int)std::min<uint64_t>(frames, MIXBLOCK);
+		MixBlock(block);
+		frames -= block;
+	}
+	MixTime.Unclock();
+	LastMixMS = MixTime.TimeMS();
+
+	PurgeStoppedVoices();
+}
+
+void SoftSoundRenderer::MixBlock(int frames)
+{
+	memset(&MixBuffer[0], 0, frames * 2 * sizeof(float));
+
+	if (!SyncPaused)
+	{
+		for (auto voice : ActiveVoices)
+		{
+			if (voice->Finished || (voice->Pausable && SFXPaused))
+				continue;
+			MixVoice(voice, frames);
+		}
+	}
+	for (auto stream : Streams)
+	{
+		if (stream->Playing && !stream->Paused)
+			MixStream(stream, frames);
+	}
+
+	FramesMixed += frames;
+	if (WavFile != nullptr)
+	{
+		WriteOutput(frames);
+	}
+}
+
+//==========================================================================
+//
+// Adds VoiceBuffer to MixBuffer with separate gains for both channels.
+//
+//==========================================================================
+
+static void AccumulateStereo(float *out, const float *in, int frames, float gainl, float gainr)
+{
+	int i = 0;
+#ifndef NO_SSE
+	__m128 gains = _mm_setr_ps(gainl, gainr, gainl, gainr);
+	for (; i + 2 <= frames; i += 2)
+	{
+		__m128 src = _mm_loadu_ps(in + i * 2);
+		__m128 dst = _mm_loadu_ps(out + i * 2);
+		_mm_storeu_ps(out + i * 2, _mm_add_ps(dst, _mm_mul_ps(src, gains)));
+	}
+#endif
+	for (; i < frames; i++)
+	{
+		out[i * 2] += in[i * 2] * gainl;
+		out[i * 2 + 1] += in[i * 2 + 1] * gainr;
+	}
+}
+
+void SoftSoundRenderer::MixVoice(SoftVoice *voice, int frames)
+{
+	if (voice->GainL == 0 && voice->GainR == 0 && !voice->Loop)
+	{
+		// Inaudible, but the position still has to advance.
+		uint64_t end = uint64_t(voice->Sample->Frames) << 32;
+		voice->Pos += voice->Step * frames;
+		if (voice->Pos >= end)
+		{
+			voice->Pos = end;
+			voice->Finished = true;
+		}
+		return;
+	}
+
+	const SoftSample *sample = voice->Sample;
+	const int16_t *data = &sample->Data[0];
+	const uint32_t end = voice->Loop ? sample->LoopEnd : sample->Frames;
+	const uint64_t looplen = uint64_t(sample->LoopEnd - sample->LoopStart) << 32;
+	const bool stereo = sample->Channels == 2;
+	const bool downmix = stereo && voice->Is3D;
+	float *out = &VoiceBuffer[0];
+	uint64_t pos = voice->Pos;
+	int i;
+
+	for (i = 0; i < frames; i++)
+	{
+		uint32_t idx = uint32_t(pos >> 32);
+		if (idx >= end)
+		{
+			if (!voice->Loop || looplen == 0)
+			{
+				voice->Finished = true;
+				pos = uint64_t(sample->Frames) << 32;
+				break;
+			}
+			pos -= looplen * ((pos - (uint64_t(end) << 32)) / looplen + 1);
+			idx = uint32_t(pos >> 32);
+		}
+		uint32_t next = idx + 1 < end ? idx + 1 : voice->Loop ? sample->LoopStart : idx;
+		float frac = float(uint32_t(pos)) * (1.f / 4294967296.f);
+
+		float l, r;
+		if (!stereo)
+		{
+			float a = data[idx], b = data[next];
+			l = r = a + (b - a) * frac;
+		}
+		else
+		{
+			float al = data[idx * 2], bl = data[next * 2];
+			float ar = data[idx * 2 + 1], br = data[next * 2 + 1];
+			l = al + (bl - al) * frac;
+			r = ar + (br - ar) * frac;
+			if (downmix) l = r = (l + r) * 0.5f;
+		}
+		out[i * 2] = l;
+		out[i * 2 + 1] = r;
+		pos += voice->Step;
+	}
+	voice->Pos = pos;
+
+	AccumulateStereo(&MixBuffer[0], out, i, voice->GainL * (1.f / 32768), voice->GainR * (1.f / 32768));
+}
+
+void SoftSoundRenderer::MixStream(SoftSoundStream *stream, int frames)
+{
+	const uint64_t step = uint64_t((double)stream->SampleRate / OutputRate * 4294967296.);
+	const unsigned needed = unsigned(((stream->Frac + step * frames) >> 32) + 2);
+
+	while (stream->Pending.Size() / 2 - stream->PendingPos < needed)
+	{
+		if (!stream->Fill())
+		{
+			stream->Playing = false;
+			break;
+		}
+	}
+
+	const float *in = &stream->Pending[stream->PendingPos * 2];
+	const unsigned avail = stream->Pending.Size() / 2 - stream->PendingPos;
+	float *out = &VoiceBuffer[0];
+	uint64_t pos = stream->Frac;
+	int i;
+
+	for (i = 0; i < frames; i++)
+	{
+		unsigned idx = unsigned(pos >> 32);
+		if (idx + 1 >= avail) break;
+		float frac = float(uint32_t(pos)) * (1.f / 4294967296.f);
+		out[i * 2] = in[idx * 2] + (in[idx * 2 + 2] - in[idx * 2]) * frac;
+		out[i * 2 + 1] = in[idx * 2 + 1] + (in[idx * 2 + 3] - in[idx * 2 + 1]) * frac;
+		pos += step;
+	}
+
+	float gain = MusicVolume * stream->Volume;
+	AccumulateStereo(&MixBuffer[0], out, i, gain, gain);
+
+	stream->PendingPos += unsigned(pos >> 32);
+	stream->Frac = uint32_t(pos);
+	if (stream->PendingPos > 4096)
+	{
+		stream->Pending.Delete(0, stream->PendingPos * 2);
+		stream->PendingPos = 0;
+	}
+}
+
+void SoftSoundRenderer::WriteOutput(int frames)
+{
+	const float *in = &MixBuffer[0];
+	int16_t *out = &OutBuffer[0];
+	const float scale = Inactive == INACTIVE_Mute ? 0.f : 32767.f;
+	int i = 0;
+
+#ifndef NO_SSE
+	// _mm_packs_epi32 saturates, so no explicit clamping is needed.
+	__m128 vscale = _mm_set1_ps(scale);
+	for (; i + 8 <= frames * 2; i += 8)
+	{
+		__m128i a = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(in + i), vscale));
+		__m128i b = _mm_cvtps_epi32(_mm_mul_ps(_mm_loadu_ps(in + i + 4), vscale));
+		_mm_storeu_si128((__m128i *)(out + i), _mm_packs_epi32(a, b));
+	}
+#endif
+	for (; i < frames * 2; i++)
+	{
+		out[i] = (int16_t)clamp<int>(xs_RoundToInt(in[i] * scale), -32768, 32767);
+	}
+	for (i = 0; i < frames * 2; i++)
+	{
+		out[i] = LittleShort(out[i]);
+	}
+
+	WavBytes += (uint32_t)WavFile->Write(out, frames * 4);
+}
+
+//==========================================================================
+//
+// Status
+//
+//==========================================================================
+
+void SoftSoundRenderer::PrintStatus()
+{
+	Printf("Software mixer, " TEXTCOLOR_BLUE "%d" TEXTCOLOR_NORMAL "hz, " TEXTCOLOR_BLUE "%u" TEXTCOLOR_NORMAL " voices\n", OutputRate, Voices.Size());
+	if (WavFile != nullptr)
+		Printf("Writing output to " TEXTCOLOR_ORANGE "%s\n", WavName.GetChars());
+	else
+		Printf("Output is discarded\n");
+}
+
+void SoftSoundRenderer::PrintDriversList()
+{
+	Printf("Software mixer uses no drivers.\n");
+}
+
+FString SoftSoundRenderer::GatherStats()
+{
+	FString out;
+	out.Format("%u voices (" TEXTCOLOR_YELLOW "%u" TEXTCOLOR_NORMAL " active, " TEXTCOLOR_YELLOW "%u" TEXTCOLOR_NORMAL " peak), "
+		"%u streams, mix " TEXTCOLOR_YELLOW "%.3f" TEXTCOLOR_NORMAL "ms, " TEXTCOLOR_YELLOW "%.1f" TEXTCOLOR_NORMAL "s mixed",
+		Voices.Size(), ActiveVoices.Size(), PeakVoices, Streams.Size(), LastMixMS, FramesMixed / (double)OutputRate);
+	return out;
+}
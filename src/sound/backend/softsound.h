@@ -0,0 +1,114 @@
+#ifndef SOFTSOUND_H
+#define SOFTSOUND_H
+
+#include "i_sound.h"
+#include "s_soundinternal.h"
+#include "stats.h"
+
+class FileWriter;
+class SoftSoundStream;
+struct SoftSample;
+struct SoftVoice;
+
+//==========================================================================
+//
+// SoftSoundRenderer
+//
+// A sound renderer that does all of its mixing on the CPU. It does not
+// talk to any audio device: the mixed output is either written to a WAV
+// file or thrown away. This makes it possible to run the complete channel,
+// attenuation and streaming code on a machine without any sound hardware,
+// e.g. for benchmarking or comparing the output of two builds.
+//
+//==========================================================================
+
+class SoftSoundRenderer : public SoundRenderer
+{
+public:
+	SoftSoundRenderer(const char *wavfile);
+	virtual ~SoftSoundRenderer();
+
+	virtual void SetSfxVolume(float volume);
+	virtual void SetMusicVolume(float volume);
+	virtual SoundHandle LoadSound(uint8_t *sfxdata, int length);
+	virtual SoundHandle LoadSoundRaw(uint8_t *sfxdata, int length, int frequency, int channels, int bits, int loopstart, int loopend = -1);
+	virtual void UnloadSound(SoundHandle sfx);
+	virtual unsigned int GetMSLength(SoundHandle sfx);
+	virtual unsigned int GetSampleLength(SoundHandle sfx);
+	virtual float GetOutputRate();
+
+	// Streaming sounds.
+	virtual SoundStream *CreateStream(SoundStreamCallback callback, int buffbytes, int flags, int samplerate, void *userdata);
+
+	// Starts a sound.
+	virtual FISoundChannel *StartSound(SoundHandle sfx, float vol, int pitch, int chanflags, FISoundChannel *reuse_chan, float startTime);
+	virtual FISoundChannel *StartSound3D(SoundHandle sfx, SoundListener *listener, float vol, FRolloffInfo *rolloff, float distscale, int pitch, int priority, const FVector3 &pos, const FVector3 &vel, int channum, int chanflags, FISoundChannel *reuse_chan, float startTime);
+
+	virtual void ChannelVolume(FISoundChannel *chan, float volume);
+	virtual void ChannelPitch(FISoundChannel *chan, float pitch);
+	virtual void StopChannel(FISoundChannel *chan);
+	virtual unsigned int GetPosition(FISoundChannel *chan);
+	virtual void Sync(bool sync);
+	virtual void SetSfxPaused(bool paused, int slot);
+	virtual void SetInactive(SoundRenderer::EInactiveState inactive);
+	virtual void UpdateSoundParams3D(SoundListener *listener, FISoundChannel *chan, bool areasound, const FVector3 &pos, const FVector3 &vel);
+	virtual void UpdateListener(SoundListener *);
+	virtual void UpdateSounds();
+	virtual void MarkStartTime(FISoundChannel*, float startTime);
+	virtual float GetAudibility(FISoundChannel*);
+
+	virtual bool IsValid();
+	virtual void PrintStatus();
+	virtual void PrintDriversList();
+	virtual FString GatherStats();
+
+private:
+	friend class SoftSoundStream;
+
+	enum
+	{
+		MIXBLOCK = 512,		// frames mixed in one go
+	};
+
+	SoftVoice *AllocVoice(int priority, float dist_sqr);
+	FISoundChannel *StartVoice(SoftVoice *voice, SoftSample *sample, float vol, int pitch, int chanflags, FISoundChannel *reuse_chan, float startTime);
+	void UpdateVoicePitch(SoftVoice *voice);
+	void UpdateVoiceGains(SoftVoice *voice);
+	void PurgeStoppedVoices();
+	FSoundChan *FindLowestChannel();
+
+	void MixBlock(int frames);
+	void MixVoice(SoftVoice *voice, int frames);
+	void MixStream(SoftSoundStream *stream, int frames);
+	void WriteOutput(int frames);
+
+	int OutputRate;
+	float SfxVolume;
+	float MusicVolume;
+	int SFXPaused;
+	bool SyncPaused;
+	bool WasInWater;
+	EInactiveState Inactive;
+	SoundListener Listener;
+
+	TArray<SoftVoice> Voices;		// never resized after construction
+	TArray<SoftVoice *> FreeVoices;
+	TArray<SoftVoice *> ActiveVoices;
+	TArray<SoftSoundStream *> Streams;
+
+	TArray<float> MixBuffer;		// interleaved stereo
+	TArray<float> VoiceBuffer;		// interleaved stereo, one voice at a time
+	TArray<int16_t> OutBuffer;
+
+	FString WavName;
+	FileWriter *WavFile;
+	uint32_t WavBytes;
+
+	uint64_t LastUpdate;
+	uint64_t FramesMixed;
+	cycle_t MixTime;
+	double LastMixMS;
+	unsigned PeakVoices;
+};
+
+#endif
@@ -35,6 +35,8 @@
 #ifndef _WIN32
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <sys/resource.h>
+#include <unistd.h>
 #endif
 
 #include <zlib.h>
@@ -54,6 +56,9 @@
 #include "s_music.h"
 #include "doomstat.h"
 #include "filereadermusicinterface.h"
+#include "i_time.h"
+#include "files.h"
+#include "m_swap.h"
 
 
 
@@ -406,6 +411,29 @@ static ZMusic_MidiSource GetMIDISource(const char *fn)
 	return source;
 }
 
+//==========================================================================
+//
+// Maps the synth names accepted by the dumpers to a MIDI device.
+//
+//==========================================================================
+
+static bool GetMIDIDeviceByName(const char *name, EMidiDevice &dev)
+{
+	if (!stricmp(name, "WildMidi")) dev = MDEV_WILDMIDI;
+	else if (!stricmp(name, "GUS")) dev = MDEV_GUS;
+	else if (!stricmp(name, "Timidity") || !stricmp(name, "Timidity++")) dev = MDEV_TIMIDITY;
+	else if (!stricmp(name, "FluidSynth")) dev = MDEV_FLUIDSYNTH;
+	else if (!stricmp(name, "OPL")) dev = MDEV_OPL;
+	else if (!stricmp(name, "OPN")) dev = MDEV_OPN;
+	else if (!stricmp(name, "ADL")) dev = MDEV_ADL;
+	else
+	{
+		Printf("%s: Unknown MIDI device\n", name);
+		return false;
+	}
+	return true;
+}
+
 //==========================================================================
 //
 // CCMD writewave
@@ -425,20 +453,9 @@ UNSAFE_CCMD (writewave)
 
 		EMidiDevice dev = MDEV_DEFAULT;
 
-		if (argv.argc() >= 6)
+		if (argv.argc() >= 6 && !GetMIDIDeviceByName(argv[5], dev))
 		{
-			if (!stricmp(argv[5], "WildMidi")) dev = MDEV_WILDMIDI;
-			else if (!stricmp(argv[5], "GUS")) dev = MDEV_GUS;
-			else if (!stricmp(argv[5], "Timidity") || !stricmp(argv[5], "Timidity++")) dev = MDEV_TIMIDITY;
-			else if (!stricmp(argv[5], "FluidSynth")) dev = MDEV_FLUIDSYNTH;
-			else if (!stricmp(argv[5], "OPL")) dev = MDEV_OPL;
-			else if (!stricmp(argv[5], "OPN")) dev = MDEV_OPN;
-			else if (!stricmp(argv[5], "ADL")) dev = MDEV_ADL;
-			else
-			{
-				Printf("%s: Unknown MIDI device\n", argv[5]);
-				return;
-			}
+			return;
 		}
 		// We must stop the currently playing music to avoid interference between two synths. 
 		auto savedsong = mus_playing;
@@ -486,3 +503,242 @@ UNSAFE_CCMD(writemidi)
 		Printf("Unable to write %s\n", argv[1]);
 	}
 }
+
+//==========================================================================
+//
+// Resident memory of the process in KB, or 0 if unknown. Where the current
+// figure is not available this is the peak, which only ever grows, and
+// peak is set to say so.
+//
+//==========================================================================
+
+static size_t ResidentMemoryKB(bool &peak)
+{
+	peak = false;
+#ifdef __linux__
+	FILE *f = fopen("/proc/self/statm", "r");
+	if (f != nullptr)
+	{
+		unsigned long size, resident;
+		int got = fscanf(f, "%lu %lu", &size, &resident);
+		fclose(f);
+		if (got == 2)
+		{
+			return size_t(resident * (sysconf(_SC_PAGESIZE) / 1024));
+		}
+	}
+#endif
+#ifndef _WIN32
+	peak = true;
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) == 0)
+	{
+#ifdef __APPLE__
+		return size_t(usage.ru_maxrss / 1024);
+#else
+		return size_t(usage.ru_maxrss);
+#endif
+	}
+#endif
+	return 0;
+}
+
+//==========================================================================
+//
+// BenchmarkMIDIDevice
+//
+// Renders a song through a MIDI device as fast as possible and reports
+// how long it took. If wavname is given the output is also written to a
+// WAV file, otherwise it is discarded.
+//
+//==========================================================================
+
+static void BenchmarkMIDIDevice(const TArray<uint8_t> &data, const char *devname, EMidiDevice dev, const char *devarg, const char *wavname)
+{
+	bool peakmem;
+	size_t startmem = ResidentMemoryKB(peakmem);
+	uint64_t opentime = I_nsTime();
+
+	auto song = ZMusic_OpenSongMem(data.Data(), data.Size(), dev, devarg);
+	if (song == nullptr)
+	{
+		Printf("%s: Unable to open song: %s\n", devname, ZMusic_GetLastError());
+		return;
+	}
+
+	SoundStreamInfo info;
+	ZMusic_GetStreamInfo(song, &info);
+	if (info.mBufferSize <= 0 || info.mSampleRate <= 0 || !ZMusic_Start(song, 0, false))
+	{
+		Printf("%s: Device cannot render offline\n", devname);
+		ZMusic_Close(song);
+		return;
+	}
+	opentime = I_nsTime() - opentime;
+
+	const bool isfloat = info.mNumChannels > 0;
+	const int channels = abs(info.mNumChannels);
+	const int framesize = channels * (isfloat ? 4 : 2);
+
+	FileWriter *wav = nullptr;
+	uint32_t wavbytes = 0;
+	if (wavname != nullptr)
+	{
+		wav = FileWriter::Open(wavname);
+		if (wav == nullptr)
+		{
+			Printf("Could not open %s for writing\n", wavname);
+		}
+		else
+		{
+			uint8_t header[44];
+			memcpy(header, "RIFF\0\0\0\0WAVEfmt \x10\0\0\0", 20);
+			uint16_t format = LittleShort(uint16_t(isfloat ? 3 : 1));	// WAVE_FORMAT_IEEE_FLOAT or WAVE_FORMAT_PCM
+			uint16_t nchannels = LittleShort(uint16_t(channels));
+			uint32_t rate = LittleLong(uint32_t(info.mSampleRate));
+			uint32_t bytespersec = LittleLong(uint32_t(info.mSampleRate * framesize));
+			uint16_t blockalign = LittleShort(uint16_t(framesize));
+			uint16_t bits = LittleShort(uint16_t(isfloat ? 32 : 16));
+			memcpy(header + 20, &format, 2);
+			memcpy(header + 22, &nchannels, 2);
+			memcpy(header + 24, &rate, 4);
+			memcpy(header + 28, &bytespersec, 4);
+			memcpy(header + 32, &blockalign, 2);
+			memcpy(header + 34, &bits, 2);
+			memcpy(header + 36, "data\0\0\0\0", 8);
+			wav->Write(header, 44);
+		}
+	}
+
+	// Songs that never end are cut off after an hour.
+	const uint64_t maxframes = uint64_t(info.mSampleRate) * 3600;
+	TArray<uint8_t> buffer(info.mBufferSize, true);
+	uint64_t frames = 0;
+	uint64_t rendertime = 0;
+	uint64_t peakblock = 0;
+	int blocks = 0;
+
+	while (frames < maxframes)
+	{
+		uint64_t blockstart = I_nsTime();
+		bool more = ZMusic_FillStream(song, buffer.Data(), buffer.Size());
+		uint64_t blocktime = I_nsTime() - blockstart;
+		if (!more) break;
+
+		rendertime += blocktime;
+		peakblock = std::max(peakblock, blocktime);
+		blocks++;
+		frames += buffer.Size() / framesize;
+		if (wav != nullptr)
+		{
+			wavbytes += (uint32_t)wav->Write(buffer.Data(), buffer.Size());
+		}
+		if (!ZMusic_IsPlaying(song)) break;
+	}
+	ZMusic_Close(song);
+
+	if (wav != nullptr)
+	{
+		uint32_t size = LittleLong(wavbytes + 36);
+		wav->Seek(4, SEEK_SET);
+		wav->Write(&size, 4);
+		size = LittleLong(wavbytes);
+		wav->Seek(40, SEEK_SET);
+		wav->Write(&size, 4);
+		delete wav;
+	}
+
+	double audioms = frames * 1000. / info.mSampleRate;
+	double renderms = rendertime / 1e6;
+	// A block has to be rendered before the previous one has finished playing.
+	double blockms = buffer.Size() / framesize * 1000. / info.mSampleRate;
+	size_t endmem = ResidentMemoryKB(peakmem);
+
+	Printf("%-10s %8.1f s audio in %8.1f ms, %7.1fx real time, open %6.1f ms, block avg %.3f / peak %.3f ms (%.1f ms budget)",
+		devname, audioms / 1000., renderms, renderms > 0 ? audioms / renderms : 0., opentime / 1e6,
+		blocks > 0 ? renderms / blocks : 0., peakblock / 1e6, blockms);
+	if (endmem > 0 && startmem > 0)
+	{
+		if (peakmem) Printf(", peak memory grew %llu KB", (unsigned long long)(endmem - startmem));
+		else Printf(", memory %+lld KB", (long long)endmem - (long long)startmem);
+	}
+	Printf("\n");
+}
+
+//==========================================================================
+//
+// CCMD benchmidi
+//
+// Renders a MIDI song through one or all of the software synths without
+// playing it, to compare their CPU cost. Can be run from the command line,
+// e.g. +benchmidi d_e1m1 all +quit
+//
+//==========================================================================
+
+UNSAFE_CCMD(benchmidi)
+{
+	if (argv.argc() < 2 || argv.argc() > 5)
+	{
+		Printf("Usage: benchmidi <midi> [synth|all] [soundfont] [wavfile]\n"
+			" - use '*' as song name to benchmark the currently playing song\n"
+			" - use '-' as soundfont to use the synth's default\n"
+			" - the soundfont and WAV file are only used for a single synth\n");
+		return;
+	}
+
+	FString src = argv[1];
+	if (src.Compare("*") == 0) src = mus_playing.name;
+	auto lump = Wads.CheckNumForName(src, ns_music);
+	if (lump < 0) lump = Wads.CheckNumForFullName(src);
+	if (lump < 0)
+	{
+		Printf("Cannot find MIDI lump %s.\n", src.GetChars());
+		return;
+	}
+	auto data = Wads.ReadLumpIntoArray(lump);
+	uint32_t id[32 / 4] = {};
+	if (data.Size() >= 32) memcpy(id, data.Data(), 32);
+	if (data.Size() < 32 || ZMusic_IdentifyMIDIType(id, 32) == MIDI_NOTMIDI)
+	{
+		Printf("%s is not MIDI-based.\n", src.GetChars());
+		return;
+	}
+
+	static const struct { const char *name; EMidiDevice dev; } synths[] =
+	{
+		{ "OPL", MDEV_OPL },
+		{ "ADL", MDEV_ADL },
+		{ "OPN", MDEV_OPN },
+		{ "GUS", MDEV_GUS },
+		{ "Timidity++", MDEV_TIMIDITY },
+		{ "WildMidi", MDEV_WILDMIDI },
+		{ "FluidSynth", MDEV_FLUIDSYNTH },
+	};
+
+	const char *synth = argv.argc() >= 3 ? argv[2] : "all";
+	const char *devarg = argv.argc() >= 4 && *argv[3] && strcmp(argv[3], "-") ? argv[3] : nullptr;
+	const bool all = !stricmp(synth, "all");
+	EMidiDevice dev = MDEV_DEFAULT;
+	if (!all && !GetMIDIDeviceByName(synth, dev))
+	{
+		return;
+	}
+
+	// Stop the music so that the synths are not shared with the playing song.
+	auto savedsong = mus_playing;
+	S_StopMusic(true);
+
+	if (all)
+	{
+		for (auto &s : synths)
+		{
+			BenchmarkMIDIDevice(data, s.name, s.dev, nullptr, nullptr);
+		}
+	}
+	else
+	{
+		BenchmarkMIDIDevice(data, synth, dev, devarg, argv.argc() >= 5 ? argv[4] : nullptr);
+	}
+
+	S_ChangeMusic(savedsong.name, savedsong.baseorder, savedsong.loop, true);
+}
@@ -104,6 +104,11 @@ CUSTOM_CVAR(Int, adl_volume_model, 0 /*ADLMIDI_VolumeModel_AUTO*/, CVAR_ARCHIVE
 	FORWARD_CVAR(adl_volume_model);
 }
 
+CUSTOM_CVAR(Bool, adl_threaded_chips, 1, CVAR_ARCHIVE | CVAR_GLOBALCONFIG | CVAR_VIRTUAL)
+{
+	FORWARD_BOOL_CVAR(adl_threaded_chips);
+}
+
 //==========================================================================
 //
 // Fluidsynth MIDI device
@@ -415,7 +415,11 @@ unsigned int S_GetMSLength(FSoundID sound)
 	}
 
 	sfx = soundEngine->LoadSound(sfx);
-	if (sfx != NULL) return GSnd->GetMSLength(sfx->data);
+	if (sfx != NULL)
+	{
+		if (sfx->bLoading) soundEngine->WaitForSound(sfx, -1);
+		return GSnd->GetMSLength(sfx->data);
+	}
 	else return 0;
 }
 
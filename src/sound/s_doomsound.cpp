@@ -71,6 +71,26 @@
 
 FBoolCVar noisedebug("noise", false, 0);	// [RH] Print sound debugging info?
 
+static void S_SetDecodeOptions();
+
+// Decode compressed sounds on worker threads instead of the first time they are played.
+CUSTOM_CVAR(Bool, snd_asyncdecode, true, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+{
+	S_SetDecodeOptions();
+}
+
+// How long (ms) a sound that is still being decoded may stall the game before it gets started late.
+CUSTOM_CVAR(Int, snd_decodewait, 0, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+{
+	if (self < 0) self = 0;
+	else S_SetDecodeOptions();
+}
+
+static void S_SetDecodeOptions()
+{
+	if (soundEngine) soundEngine->SetDecodeOptions(snd_asyncdecode, snd_decodewait);
+}
+
 
 static FString LastLocalSndInfo;
 static FString LastLocalSndSeq;
@@ -122,6 +142,7 @@ void S_Init()
 	{
 		soundEngine = new DoomSoundEngine;
 	}
+	S_SetDecodeOptions();
 
 	I_InitSound();
 	I_InitMusic();
@@ -390,7 +411,7 @@ void DoomSoundEngine::StopChannel(FSoundChan* chan)
 {
 	if (chan && chan->SysChannel != NULL && !(chan->ChanFlags & CHANF_EVICTED) && chan->SourceType == SOURCE_Actor)
 	{
-		chan->Source = NULL;
+		SetChannelSource(chan, chan->SourceType, NULL);
 	}
 	SoundEngine::StopChannel(chan);
 }
@@ -784,6 +805,7 @@ void S_SerializeSounds(FSerializer &arc)
 			{
 				chan = (FSoundChan*)soundEngine->GetChannel(nullptr);
 				arc(nullptr, *chan);
+				soundEngine->IndexChannel(chan);
 				// Sounds always start out evicted when restored from a save.
 				chan->ChanFlags |= CHANF_EVICTED | CHANF_ABSTIME;
 			}
@@ -39,6 +39,13 @@
 #include <io.h>
 #endif
 #include <fcntl.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <chrono>
+#include <algorithm>
 
 #include "templates.h"
 #include "s_soundinternal.h"
@@ -55,6 +62,200 @@ enum
 static FRandom pr_soundpitch ("SoundPitch");
 SoundEngine* soundEngine;
 
+//==========================================================================
+//
+// Background sound decoding
+//
+// Compressed sounds (Ogg, FLAC, MP3...) can take several milliseconds to
+// decode, which used to happen the first time the sound was played. The
+// decoding is now done by a small pool of worker threads. Only the decoded
+// PCM data is handed to the sound backend, which always happens on the
+// main thread, so the backends do not need to be thread safe.
+//
+//==========================================================================
+
+struct FSoundLoadJob
+{
+	int SoundIndex;
+	TArray<uint8_t> Input;
+	TArray<uint8_t> Output;
+	int Rate = 0;
+	int Channels = 0;
+	int Bits = 0;
+	int LoopStart = -1;
+	int LoopEnd = -1;
+	FString Error;
+	std::atomic<bool> Cancelled{ false };
+	std::atomic<bool> Done{ false };
+	bool Dropped = false;		// removed from the queue by FSoundDecodePool::Stop without being decoded
+};
+
+const char *GetSampleTypeName(SampleType type);
+const char *GetChannelConfigName(ChannelConfig chan);
+
+// The decoder factory probes every supported format and some of the
+// libraries behind it keep global state, so creating decoders is serialized.
+// Decoding itself runs in parallel.
+static std::mutex DecoderCreateLock;
+
+static void DecodeSound(FSoundLoadJob *job)
+{
+	if (job->Cancelled) return;
+
+	uint32_t loop_start = 0, loop_end = ~0u;
+	bool startass = false, endass = false;
+	SoundDecoder *decoder;
+	{
+		std::lock_guard<std::mutex> lock(DecoderCreateLock);
+		FindLoopTags(job->Input.Data(), job->Input.Size(), &loop_start, &startass, &loop_end, &endass);
+		decoder = CreateDecoder(job->Input.Data(), job->Input.Size(), true);
+	}
+	if (decoder == nullptr) return;
+
+	ChannelConfig chans;
+	SampleType type;
+	int srate;
+	SoundDecoder_GetInfo(decoder, &srate, &chans, &type);
+
+	int channels = chans == ChannelConfig_Mono ? 1 : chans == ChannelConfig_Stereo ? 2 : 0;
+	int bits = type == SampleType_UInt8 ? 8 : type == SampleType_Int16 ? 16 : 0;
+	if (channels == 0 || bits == 0)
+	{
+		SoundDecoder_Close(decoder);
+		job->Error.Format("Unsupported audio format: %s, %s", GetChannelConfigName(chans), GetSampleTypeName(type));
+		return;
+	}
+
+	unsigned total = 0;
+	unsigned got;
+	job->Output.Resize(32768);
+	while ((got = (unsigned)SoundDecoder_Read(decoder, &job->Output[total], job->Output.Size() - total)) > 0)
+	{
+		total += got;
+		job->Output.Resize(total * 2);
+	}
+	job->Output.Resize(total);
+	SoundDecoder_Close(decoder);
+
+	job->Rate = srate;
+	job->Channels = channels;
+	job->Bits = bits;
+
+	const uint32_t samples = total / (channels * bits / 8);
+	if (!startass) loop_start = uint32_t(uint64_t(loop_start) * srate / 1000);
+	if (!endass && loop_end != ~0u) loop_end = uint32_t(uint64_t(loop_end) * srate / 1000);
+	if (loop_start > samples) loop_start = 0;
+	if (loop_end > samples) loop_end = samples;
+	if ((loop_start > 0 || loop_end < samples) && loop_end > loop_start)
+	{
+		job->LoopStart = loop_start;
+		job->LoopEnd = loop_end;
+	}
+}
+
+class FSoundDecodePool
+{
+	std::vector<std::thread> Workers;
+	std::deque<FSoundLoadJob *> Queue;
+	std::mutex Lock;
+	std::condition_variable Wake;
+	std::condition_variable Finished;
+	bool Quit = false;
+
+	void Worker()
+	{
+		for (;;)
+		{
+			FSoundLoadJob *job;
+			{
+				std::unique_lock<std::mutex> lock(Lock);
+				Wake.wait(lock, [this] { return Quit || !Queue.empty(); });
+				if (Quit) return;
+				job = Queue.front();
+				Queue.pop_front();
+			}
+			DecodeSound(job);
+			{
+				std::lock_guard<std::mutex> lock(Lock);
+				job->Done = true;
+			}
+			Finished.notify_all();
+		}
+	}
+
+public:
+	~FSoundDecodePool()
+	{
+		Stop();
+	}
+
+	void Add(FSoundLoadJob *job)
+	{
+		if (Workers.empty())
+		{
+			unsigned count = clamp(std::thread::hardware_concurrency(), 1u, 4u);
+			for (unsigned i = 0; i < count; i++)
+			{
+				Workers.push_back(std::thread([this] { Worker(); }));
+			}
+		}
+		{
+			std::lock_guard<std::mutex> lock(Lock);
+			Queue.push_back(job);
+		}
+		Wake.notify_one();
+	}
+
+	// Waits up to ms milliseconds for the job to be done. With a negative
+	// timeout a job that has not been started yet is decoded right here
+	// instead of waiting for its turn in the queue.
+	bool Wait(FSoundLoadJob *job, int ms)
+	{
+		std::unique_lock<std::mutex> lock(Lock);
+		if (ms < 0)
+		{
+			auto it = std::find(Queue.begin(), Queue.end(), job);
+			if (it != Queue.end())
+			{
+				Queue.erase(it);
+				lock.unlock();
+				DecodeSound(job);
+				job->Done = true;
+				return true;
+			}
+			Finished.wait(lock, [job] { return job->Done.load(); });
+			return true;
+		}
+		return Finished.wait_for(lock, std::chrono::milliseconds(ms), [job] { return job->Done.load(); });
+	}
+
+	// Jobs that are still queued are not decoded. They are marked as done
+	// and dropped, so that nobody waits for them forever.
+	void Stop()
+	{
+		{
+			std::lock_guard<std::mutex> lock(Lock);
+			Quit = true;
+			for (auto job : Queue)
+			{
+				job->Dropped = true;
+				job->Done = true;
+			}
+			Queue.clear();
+		}
+		Wake.notify_all();
+		Finished.notify_all();
+		for (auto &thread : Workers)
+		{
+			thread.join();
+		}
+		Workers.clear();
+		Quit = false;
+	}
+};
+
+static FSoundDecodePool DecodePool;
+
 //==========================================================================
 //
 // S_Init
@@ -104,6 +305,14 @@ void SoundEngine::Shutdown ()
 		delete chan;
 	}
 	FreeChannels = NULL;
+
+	CancelSoundLoads();
+	DecodePool.Stop();
+	for (auto job : LoadJobs)
+	{
+		delete job;
+	}
+	LoadJobs.Clear();
 }
 
 //==========================================================================
@@ -148,6 +357,8 @@ void SoundEngine::CacheMarkedSounds()
 			UnloadSound(&S_sfx[i]);
 		}
 	}
+	// The sounds were decoded in parallel. Have them all ready before play starts.
+	ProcessLoadedSounds(true);
 }
 
 //==========================================================================
@@ -185,6 +396,15 @@ void SoundEngine::CacheSound (sfxinfo_t *sfx)
 
 void SoundEngine::UnloadSound (sfxinfo_t *sfx)
 {
+	if (sfx->bLoading)
+	{
+		int index = int(sfx - &S_sfx[0]);
+		for (auto job : LoadJobs)
+		{
+			if (job->SoundIndex == index) job->Cancelled = true;
+		}
+		sfx->bLoading = false;
+	}
 	if (sfx->data.isValid())
 		GSnd->UnloadSound(sfx->data);
 	sfx->data.Clear();
@@ -227,6 +447,7 @@ FSoundChan *SoundEngine::GetChannel(void *syschan)
 
 void SoundEngine::ReturnChannel(FSoundChan *chan)
 {
+	UnindexChannel(chan);
 	UnlinkChannel(chan);
 	memset(chan, 0, sizeof(*chan));
 	LinkChannel(chan, &FreeChannels);
@@ -264,6 +485,104 @@ void SoundEngine::LinkChannel(FSoundChan *chan, FSoundChan **head)
 	chan->PrevChan = head;
 }
 
+//==========================================================================
+//
+// Channel lookup lists
+//
+// The list heads live in growable containers, so the links point to the
+// neighboring channels rather than to the head slot.
+//
+//==========================================================================
+
+static void IndexLink(FSoundChan *chan, FSoundChanLink FSoundChan::*link, FSoundChan *&head)
+{
+	(chan->*link).Prev = nullptr;
+	(chan->*link).Next = head;
+	if (head != nullptr) (head->*link).Prev = chan;
+	head = chan;
+}
+
+static void UnindexLink(FSoundChan *chan, FSoundChanLink FSoundChan::*link, FSoundChan *&head)
+{
+	FSoundChanLink &l = chan->*link;
+	if (l.Prev != nullptr) (l.Prev->*link).Next = l.Next;
+	else head = l.Next;
+	if (l.Next != nullptr) (l.Next->*link).Prev = l.Prev;
+	l.Next = l.Prev = nullptr;
+}
+
+static FSoundChan *&ListHead(TArray<FSoundChan*> &heads, int id)
+{
+	if ((unsigned)id >= heads.Size())
+	{
+		unsigned oldsize = heads.Size();
+		heads.Resize(id + 1);
+		for (unsigned i = oldsize; i < heads.Size(); i++) heads[i] = nullptr;
+	}
+	return heads[id];
+}
+
+//==========================================================================
+//
+// SoundEngine :: IndexChannel
+//
+// Adds a channel to the lookup lists. Must be called once the channel's
+// sound and source have been set up.
+//
+//==========================================================================
+
+void SoundEngine::IndexChannel(FSoundChan *chan)
+{
+	UnindexChannel(chan);
+	IndexLink(chan, &FSoundChan::ByOrgID, ListHead(OrgIDChannels, chan->OrgID));
+	IndexLink(chan, &FSoundChan::BySoundID, ListHead(SoundIDChannels, chan->SoundID));
+	IndexLink(chan, &FSoundChan::BySource, SourceChannels[chan->Source]);
+	chan->Indexed = true;
+}
+
+//==========================================================================
+//
+// SoundEngine :: UnindexChannel
+//
+//==========================================================================
+
+void SoundEngine::UnindexChannel(FSoundChan *chan)
+{
+	if (!chan->Indexed)
+	{
+		return;
+	}
+	UnindexLink(chan, &FSoundChan::ByOrgID, ListHead(OrgIDChannels, chan->OrgID));
+	UnindexLink(chan, &FSoundChan::BySoundID, ListHead(SoundIDChannels, chan->SoundID));
+	FSoundChan *&head = SourceChannels[chan->Source];
+	UnindexLink(chan, &FSoundChan::BySource, head);
+	if (head == nullptr)
+	{
+		SourceChannels.Remove(chan->Source);
+	}
+	chan->Indexed = false;
+}
+
+//==========================================================================
+//
+// SoundEngine :: SetChannelSource
+//
+// Changes the source of a channel and keeps the lookup lists in sync.
+//
+//==========================================================================
+
+void SoundEngine::SetChannelSource(FSoundChan *chan, int sourcetype, const void *source)
+{
+	if (chan->Source != source)
+	{
+		bool indexed = chan->Indexed;
+		UnindexChannel(chan);
+		chan->Source = source;
+		if (indexed) IndexChannel(chan);
+	}
+	chan->SourceType = sourcetype;
+}
+
 //==========================================================================
 //
 //
@@ -480,8 +799,10 @@ FSoundChan *SoundEngine::StartSound(int type, const void *source,
 		return NULL;
 	}
 
-	// Make sure the sound is loaded.
+	// Make sure the sound is loaded. If it is still being decoded give it
+	// a moment to finish, otherwise it starts as soon as it is ready.
 	sfx = LoadSound(sfx);
+	bool pending = sfx->bLoading && !WaitForSound(sfx, DecodeWait);
 
 	// The empty sound never plays.
 	if (sfx->lumpnum == sfx_empty)
@@ -547,6 +868,13 @@ FSoundChan *SoundEngine::StartSound(int type, const void *source,
 	{
 		chan = NULL;
 	}
+	else if (pending)
+	{
+		chan = (FSoundChan*)GetChannel(NULL);
+		if (chanflags & CHANF_LOOP) GSnd->MarkStartTime(chan);
+		else chan->StartTime = 0;
+		chanflags |= CHANF_EVICTED;
+	}
 	else 
 	{
 		int startflags = 0;
@@ -605,6 +933,7 @@ FSoundChan *SoundEngine::StartSound(int type, const void *source,
 		{
 			chan->Source = source;
 		}
+		IndexChannel(chan);
 		
 		if (spitch > 0.0)				// A_StartSound has top priority over all others.
 			SetPitch(chan, spitch);
@@ -647,13 +976,13 @@ void SoundEngine::RestartChannel(FSoundChan *chan)
 	sfxinfo_t *sfx = &S_sfx[chan->SoundID];
 
 	// If this is a singular sound, don't play it if it's already playing.
-	if (sfx->bSingular && CheckSingular(chan->SoundID))
+	if (sfx->bSingular && CheckSingular(chan->SoundID, chan))
 		return;
 
 	sfx = LoadSound(sfx);
 
 	// The empty sound never plays.
-	if (sfx->lumpnum == sfx_empty)
+	if (sfx->lumpnum == sfx_empty || sfx->bLoading)
 	{
 		return;
 	}
@@ -712,7 +1041,7 @@ sfxinfo_t *SoundEngine::LoadSound(sfxinfo_t *sfx)
 {
 	if (GSnd->IsNull()) return sfx;
 
-	while (!sfx->data.isValid())
+	while (!sfx->data.isValid() && !sfx->bLoading)
 	{
 		unsigned int i;
 
@@ -725,7 +1054,7 @@ sfxinfo_t *SoundEngine::LoadSound(sfxinfo_t *sfx)
 		// then set this one up as a link, and don't load the sound again.
 		for (i = 0; i < S_sfx.Size(); i++)
 		{
-			if (S_sfx[i].data.isValid() && S_sfx[i].link == sfxinfo_t::NO_LINK && S_sfx[i].lumpnum == sfx->lumpnum &&
+			if ((S_sfx[i].data.isValid() || S_sfx[i].bLoading) && S_sfx[i].link == sfxinfo_t::NO_LINK && S_sfx[i].lumpnum == sfx->lumpnum &&
 				(!sfx->bLoadRAW || (sfx->RawRate == S_sfx[i].RawRate)))	// Raw sounds with different sample rates may not share buffers, even if they use the same source data.
 			{
 				//DPrintf (DMSG_NOTIFY, "Linked %s to %s (%d)\n", sfx->name.GetChars(), S_sfx[i].name.GetChars(), i);
@@ -763,6 +1092,11 @@ sfxinfo_t *SoundEngine::LoadSound(sfxinfo_t *sfx)
 				sfx->data = GSnd->LoadSoundRaw(sfxdata.Data()+8, dmxlen, frequency, 1, 8, sfx->LoopStart);
 			}
 			// If that fails, let the sound system try and figure it out.
+			else if (AsyncDecode)
+			{
+				QueueSoundLoad(sfx, sfxdata);
+				return sfx;
+			}
 			else
 			{
 				sfx->data = GSnd->LoadSound(sfxdata.Data(), size);
@@ -784,20 +1118,144 @@ sfxinfo_t *SoundEngine::LoadSound(sfxinfo_t *sfx)
 
 //==========================================================================
 //
-// S_CheckSingular
+// SoundEngine :: QueueSoundLoad
 //
-// Returns true if a copy of this sound is already playing.
+// Hands a compressed sound to the decoder threads.
 //
 //==========================================================================
 
-bool SoundEngine::CheckSingular(int sound_id)
+void SoundEngine::QueueSoundLoad(sfxinfo_t *sfx, TArray<uint8_t> &sfxdata)
 {
-	for (FSoundChan *chan = Channels; chan != NULL; chan = chan->NextChan)
+	auto job = new FSoundLoadJob;
+	job->SoundIndex = int(sfx - &S_sfx[0]);
+	job->Input = std::move(sfxdata);
+	sfx->bLoading = true;
+	LoadJobs.Push(job);
+	DecodePool.Add(job);
+}
+
+//==========================================================================
+//
+// SoundEngine :: FinishSoundLoad
+//
+// Uploads the decoded data of a finished job to the sound backend.
+//
+//==========================================================================
+
+void SoundEngine::FinishSoundLoad(FSoundLoadJob *job)
+{
+	if (job->Cancelled) return;
+
+	sfxinfo_t *sfx = &S_sfx[job->SoundIndex];
+	sfx->bLoading = false;
+	if (job->Dropped)
 	{
-		if (chan->OrgID == sound_id)
+		// Never decoded, so leave the sound to be loaded again later.
+		return;
+	}
+	if (job->Error.IsNotEmpty())
+	{
+		Printf("%s: %s\n", sfx->name.GetChars(), job->Error.GetChars());
+	}
+	if (job->Output.Size() > 0)
+	{
+		sfx->data = GSnd->LoadSoundRaw(job->Output.Data(), job->Output.Size(), job->Rate, job->Channels, job->Bits, job->LoopStart, job->LoopEnd);
+	}
+	if (!sfx->data.isValid())
+	{
+		sfx->lumpnum = sfx_empty;
+	}
+}
+
+//==========================================================================
+//
+// SoundEngine :: ProcessLoadedSounds
+//
+// Finishes all sounds the decoder threads are done with. With wait set
+// this does not return before all pending sounds are loaded.
+//
+//==========================================================================
+
+void SoundEngine::ProcessLoadedSounds(bool wait)
+{
+	for (unsigned i = 0; i < LoadJobs.Size(); )
+	{
+		auto job = LoadJobs[i];
+		if (wait)
 		{
-			return true;
+			DecodePool.Wait(job, -1);
+		}
+		if (!job->Done)
+		{
+			i++;
+			continue;
 		}
+		FinishSoundLoad(job);
+		delete job;
+		LoadJobs.Delete(i);
+	}
+}
+
+//==========================================================================
+//
+// SoundEngine :: WaitForSound
+//
+// Waits up to ms milliseconds (forever if negative) for a sound that is
+// being decoded. Returns true if the sound is ready afterward.
+//
+//==========================================================================
+
+bool SoundEngine::WaitForSound(sfxinfo_t *sfx, int ms)
+{
+	int index = int(sfx - &S_sfx[0]);
+	for (auto job : LoadJobs)
+	{
+		if (job->SoundIndex == index && !job->Cancelled)
+		{
+			DecodePool.Wait(job, ms);
+			break;
+		}
+	}
+	ProcessLoadedSounds(false);
+	return !sfx->bLoading;
+}
+
+//==========================================================================
+//
+// SoundEngine :: CancelSoundLoads
+//
+//==========================================================================
+
+void SoundEngine::CancelSoundLoads()
+{
+	for (auto job : LoadJobs)
+	{
+		if (!job->Cancelled)
+		{
+			S_sfx[job->SoundIndex].bLoading = false;
+			job->Cancelled = true;
+		}
+	}
+}
+
+//==========================================================================
+//
+// S_CheckSingular
+//
+// Returns true if a copy of this sound is already playing. A channel that
+// is being restarted passes itself as exclude, since it is still indexed.
+//
+//==========================================================================
+
+bool SoundEngine::CheckSingular(int sound_id, FSoundChan *exclude)
+{
+	if ((unsigned)sound_id >= OrgIDChannels.Size())
+	{
+		return false;
+	}
+	for (FSoundChan *chan = OrgIDChannels[sound_id]; chan != nullptr; chan = chan->ByOrgID.Next)
+	{
+		if (chan != exclude) return true;
 	}
 	return false;
 }
@@ -824,10 +1282,15 @@ bool SoundEngine::CheckSoundLimit(sfxinfo_t *sfx, const FVector3 &pos, int near_
 {
 	FSoundChan *chan;
 	int count;
-	
-	for (chan = Channels, count = 0; chan != NULL && count < near_limit; chan = chan->NextChan)
+	unsigned sound_id = unsigned(sfx - &S_sfx[0]);
+
+	if (sound_id >= SoundIDChannels.Size())
+	{
+		return false;
+	}
+	for (chan = SoundIDChannels[sound_id], count = 0; chan != NULL && count < near_limit; chan = chan->BySoundID.Next)
 	{
-		if (!(chan->ChanFlags & CHANF_EVICTED) && &S_sfx[chan->SoundID] == sfx)
+		if (!(chan->ChanFlags & CHANF_EVICTED))
 		{
 			FVector3 chanorigin;
 
@@ -859,14 +1322,15 @@ bool SoundEngine::CheckSoundLimit(sfxinfo_t *sfx, const FVector3 &pos, int near_
 
 void SoundEngine::StopSoundID(int sound_id)
 {
-	FSoundChan* chan = Channels;
+	if ((unsigned)sound_id >= OrgIDChannels.Size())
+	{
+		return;
+	}
+	FSoundChan* chan = OrgIDChannels[sound_id];
 	while (chan != NULL)
 	{
-		FSoundChan* next = chan->NextChan;
-		if (sound_id == chan->OrgID)
-		{
-			StopChannel(chan);
-		}
+		FSoundChan* next = chan->ByOrgID.Next;
+		StopChannel(chan);
 		chan = next;
 	}
 }
@@ -903,12 +1367,11 @@ void SoundEngine::StopSound (int channel, int sound_id)
 
 void SoundEngine::StopSound(int sourcetype, const void* actor, int channel, int sound_id)
 {
-	FSoundChan* chan = Channels;
+	FSoundChan* chan = ChannelsWithSource(actor);
 	while (chan != NULL)
 	{
-		FSoundChan* next = chan->NextChan;
+		FSoundChan* next = chan->BySource.Next;
 		if (chan->SourceType == sourcetype &&
-			chan->Source == actor &&
 			(sound_id == -1? (chan->EntChannel == channel || channel < 0) : (chan->OrgID == sound_id)))
 		{
 			StopChannel(chan);
@@ -935,12 +1398,11 @@ void SoundEngine::StopActorSounds(int sourcetype, const void* actor, int chanmin
 		chanmin = temp;
 	}
 
-	FSoundChan* chan = Channels;
+	FSoundChan* chan = ChannelsWithSource(actor);
 	while (chan != nullptr)
 	{
-		FSoundChan* next = chan->NextChan;
+		FSoundChan* next = chan->BySource.Next;
 		if (chan->SourceType == sourcetype &&
-			chan->Source == actor &&
 			(all || (chan->EntChannel >= chanmin && chan->EntChannel <= chanmax)))
 		{
 			StopChannel(chan);
@@ -982,20 +1444,19 @@ void SoundEngine::RelinkSound (int sourcetype, const void *from, const void *to,
 	if (from == NULL)
 		return;
 
-	FSoundChan *chan = Channels;
+	FSoundChan *chan = ChannelsWithSource(from);
 	while (chan != NULL)
 	{
-		FSoundChan *next = chan->NextChan;
-		if (chan->SourceType == sourcetype && chan->Source == from)
+		FSoundChan *next = chan->BySource.Next;
+		if (chan->SourceType == sourcetype)
 		{
 			if (to != NULL)
 			{
-				chan->Source = to;
+				SetChannelSource(chan, sourcetype, to);
 			}
 			else if (!(chan->ChanFlags & CHANF_LOOP) && optpos)
 			{
-				chan->Source = NULL;
-				chan->SourceType = SOURCE_Unattached;
+				SetChannelSource(chan, SOURCE_Unattached, NULL);
 				chan->Point[0] = optpos->X;
 				chan->Point[1] = optpos->Y;
 				chan->Point[2] = optpos->Z;
@@ -1126,9 +1587,9 @@ bool SoundEngine::IsChannelUsed(int sourcetype, const void *actor, int channel,
 	{
 		return true;
 	}
-	for (FSoundChan *chan = Channels; chan != NULL; chan = chan->NextChan)
+	for (FSoundChan *chan = ChannelsWithSource(actor); chan != NULL; chan = chan->BySource.Next)
 	{
-		if (chan->SourceType == sourcetype && chan->Source == actor)
+		if (chan->SourceType == sourcetype)
 		{
 			*seen |= 1 << chan->EntChannel;
 			if (chan->EntChannel == channel)
@@ -1148,9 +1609,11 @@ bool SoundEngine::IsChannelUsed(int sourcetype, const void *actor, int channel,
 
 bool SoundEngine::IsSourcePlayingSomething (int sourcetype, const void *actor, int channel, int sound_id)
 {
-	for (FSoundChan *chan = Channels; chan != NULL; chan = chan->NextChan)
+	// Unpositioned sounds match regardless of their source, so they cannot use the source lists.
+	const bool anysource = (sourcetype == SOURCE_None || sourcetype == SOURCE_Unattached);
+	for (FSoundChan *chan = anysource ? Channels : ChannelsWithSource(actor); chan != NULL; chan = anysource ? chan->NextChan : chan->BySource.Next)
 	{
-		if (chan->SourceType == sourcetype && (sourcetype == SOURCE_None || sourcetype == SOURCE_Unattached || chan->Source == actor))
+		if (chan->SourceType == sourcetype)
 		{
 			if ((channel == 0 || chan->EntChannel == channel) && (sound_id <= 0 || chan->OrgID == sound_id))
 			{
@@ -1212,6 +1675,11 @@ void SoundEngine::RestoreEvictedChannel(FSoundChan *chan)
 	RestoreEvictedChannel(chan->NextChan);
 	if (chan->ChanFlags & CHANF_EVICTED)
 	{
+		// Keep sounds that are still being decoded until they can be started.
+		if (LoadSound(&S_sfx[chan->SoundID])->bLoading)
+		{
+			return;
+		}
 		RestartChannel(chan);
 		if (!(chan->ChanFlags & CHANF_LOOP))
 		{
@@ -1257,6 +1725,8 @@ void SoundEngine::UpdateSounds(int time)
 {
 	FVector3 pos, vel;
 
+	ProcessLoadedSounds(false);
+
 	for (FSoundChan* chan = Channels; chan != NULL; chan = chan->NextChan)
 	{
 		if ((chan->ChanFlags & (CHANF_EVICTED | CHANF_IS3D)) == CHANF_IS3D)
@@ -1636,7 +2106,11 @@ unsigned int SoundEngine::GetMSLength(FSoundID sound)
 	}
 
 	sfx = LoadSound(sfx);
-	if (sfx != NULL) return GSnd->GetMSLength(sfx->data);
+	if (sfx != NULL)
+	{
+		if (sfx->bLoading) WaitForSound(sfx, -1);
+		return GSnd->GetMSLength(sfx->data);
+	}
 	else return 0;
 }
 
@@ -2,6 +2,8 @@
 
 #include "i_sound.h"
 
+struct FSoundLoadJob;
+
 struct FRandomSoundList
 {
 	TArray<uint32_t> Choices;
@@ -43,6 +45,7 @@ struct sfxinfo_t
 	bool		bUsed = false;
 	bool		bSingular = false;
 	bool		bTentative = true;
+	bool		bLoading = false;					// Being decoded in the background. Only touched by the main thread.
 
 	TArray<int> UserData;
 
@@ -130,6 +133,15 @@ public:
 
 
 
+struct FSoundChan;
+
+// Links a channel into one of the engine's per-sound or per-source lookup lists.
+struct FSoundChanLink
+{
+	FSoundChan *Next;
+	FSoundChan *Prev;
+};
+
 struct FSoundChan : public FISoundChannel
 {
 	FSoundChan	*NextChan;	// Next channel in this list.
@@ -146,6 +158,13 @@ struct FSoundChan : public FISoundChannel
 	float		LimitRange;
 	const void *Source;
 	float Point[3];	// Sound is not attached to any source.
+
+	// Lookup lists maintained by the sound engine. Fields these are keyed on
+	// must not be changed while the channel is indexed.
+	FSoundChanLink ByOrgID;
+	FSoundChanLink BySoundID;
+	FSoundChanLink BySource;
+	bool		Indexed;
 };
 
 
@@ -214,13 +233,31 @@ protected:
 	TMap<int, int> ResIdMap;
 	TArray<FRandomSoundList> S_rnd;
 	bool blockNewSounds = false;
+	TArray<FSoundLoadJob*> LoadJobs;	// sounds being decoded in the background
+	bool AsyncDecode = true;
+	int DecodeWait = 0;				// ms StartSound waits for a sound that is being decoded
+
+	// Active channels by OrgID, by SoundID and by source, so that the
+	// per-sound and per-source checks do not have to walk all channels.
+	TArray<FSoundChan*> OrgIDChannels;
+	TArray<FSoundChan*> SoundIDChannels;
+	TMap<const void*, FSoundChan*> SourceChannels;
 
 private:
+	void QueueSoundLoad(sfxinfo_t* sfx, TArray<uint8_t>& sfxdata);
+	void FinishSoundLoad(FSoundLoadJob* job);
+	void CancelSoundLoads();
 	void LinkChannel(FSoundChan* chan, FSoundChan** head);
 	void UnlinkChannel(FSoundChan* chan);
 	void ReturnChannel(FSoundChan* chan);
 	void RestartChannel(FSoundChan* chan);
 	void RestoreEvictedChannel(FSoundChan* chan);
+	void UnindexChannel(FSoundChan* chan);
+	FSoundChan* ChannelsWithSource(const void* source)
+	{
+		auto p = SourceChannels.CheckKey(source);
+		return p ? *p : nullptr;
+	}
 
 	bool IsChannelUsed(int sourcetype, const void* actor, int channel, int* seen);
 	// This is the actual sound positioning logic which needs to be provided by the client.
@@ -231,7 +268,7 @@ private:
 	bool ValidatePosVel(const FSoundChan* const chan, const FVector3& pos, const FVector3& vel);
 
 	// Checks if a copy of this sound is already playing.
-	bool CheckSingular(int sound_id);
+	bool CheckSingular(int sound_id, FSoundChan *exclude = nullptr);
 	virtual TArray<uint8_t> ReadSound(int lumpnum) = 0;
 protected:
 	virtual bool CheckSoundLimit(sfxinfo_t* sfx, const FVector3& pos, int near_limit, float limit_range, int sourcetype, const void* actor, int channel, float attenuation);
@@ -254,6 +291,13 @@ public:
 
 	virtual void StopChannel(FSoundChan* chan);
 	sfxinfo_t* LoadSound(sfxinfo_t* sfx);
+	void ProcessLoadedSounds(bool wait);
+	bool WaitForSound(sfxinfo_t* sfx, int ms);
+	void SetDecodeOptions(bool async, int waitms)
+	{
+		AsyncDecode = async;
+		DecodeWait = waitms;
+	}
 
 	// Initializes sound stuff, including volume
 	// Sets channels, SFX and music volume,
@@ -269,6 +313,8 @@ public:
 	void SetVolume(FSoundChan* chan, float vol);
 
 	FSoundChan* GetChannel(void* syschan);
+	void IndexChannel(FSoundChan* chan);
+	void SetChannelSource(FSoundChan* chan, int sourcetype, const void* source);
 	void RestoreEvictedChannels();
 	void CalcPosVel(FSoundChan* chan, FVector3* pos, FVector3* vel);
 
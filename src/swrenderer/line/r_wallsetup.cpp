@@ -46,6 +46,10 @@
 #include "swrenderer/scene/r_light.h"
 #include "swrenderer/viewport/r_viewport.h"
 
+#ifndef NO_SSE
+#include <emmintrin.h>
+#endif
+
 namespace swrenderer
 {
 	ProjectedWallCull ProjectedWallLine::Project(RenderViewport *viewport, double z, const FWallCoords *wallc)
@@ -73,9 +77,45 @@ namespace swrenderer
 			return ProjectedWallCull::Visible;
 
 		float rcp_delta = 1.0f / (wallc->sx2 - wallc->sx1);
-		if (y1 >= 0.0f && y2 >= 0.0f && xs_RoundToInt(y1) <= viewheight && xs_RoundToInt(y2) <= viewheight)
+		bool clipped = !(y1 >= 0.0f && y2 >= 0.0f && xs_RoundToInt(y1) <= viewheight && xs_RoundToInt(y2) <= viewheight);
+		int x = wallc->sx1;
+
+#ifndef NO_SSE
+		// 8 columns at a time, with the same interpolation as the scalar loop below. The clamping
+		// is done in float so that huge values cannot overflow the conversion. The rounding
+		// rounds ties up like xs_RoundToInt: round to nearest even, then fix up the ties that
+		// went down. y minus its rounded value is exact, so the tie test is too.
 		{
-			for (int x = wallc->sx1; x < wallc->sx2; x++)
+			__m128 my1 = _mm_set1_ps(y1);
+			__m128 my2 = _mm_set1_ps(y2);
+			__m128 mrcp = _mm_set1_ps(rcp_delta);
+			__m128 one = _mm_set1_ps(1.0f);
+			__m128 half = _mm_set1_ps(0.5f);
+			__m128 mmin = _mm_setzero_ps();
+			__m128 mmax = _mm_set1_ps((float)viewheight);
+			__m128 index[2] = { _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f), _mm_setr_ps(4.0f, 5.0f, 6.0f, 7.0f) };
+			for (; x + 8 <= wallc->sx2; x += 8)
+			{
+				__m128 base = _mm_set1_ps((float)(x - wallc->sx1));
+				__m128i yi[2];
+				for (int i = 0; i < 2; i++)
+				{
+					__m128 t = _mm_mul_ps(_mm_add_ps(base, index[i]), mrcp);
+					__m128 y = _mm_add_ps(_mm_mul_ps(my1, _mm_sub_ps(one, t)), _mm_mul_ps(my2, t));
+					if (clipped)
+						y = _mm_min_ps(_mm_max_ps(y, mmin), mmax);
+					__m128i r = _mm_cvtps_epi32(y);
+					__m128 tie = _mm_cmpeq_ps(_mm_sub_ps(y, _mm_cvtepi32_ps(r)), half);
+					yi[i] = _mm_sub_epi32(r, _mm_castps_si128(tie));
+				}
+				_mm_storeu_si128((__m128i*)&ScreenY[x], _mm_packs_epi32(yi[0], yi[1]));
+			}
+		}
+#endif
+
+		if (!clipped)
+		{
+			for (; x < wallc->sx2; x++)
 			{
 				float t = (x - wallc->sx1) * rcp_delta;
 				float y = y1 * (1.0f - t) + y2 * t;
@@ -84,7 +124,7 @@ namespace swrenderer
 		}
 		else
 		{
-			for (int x = wallc->sx1; x < wallc->sx2; x++)
+			for (; x < wallc->sx2; x++)
 			{
 				float t = (x - wallc->sx1) * rcp_delta;
 				float y = y1 * (1.0f - t) + y2 * t;
@@ -180,31 +220,43 @@ namespace swrenderer
 		float depthScale = (float)(WallT.InvZstep * viewport->WallTMapScale2);
 		float depthOrg = (float)(-WallT.UoverZstep * viewport->WallTMapScale2);
 
-		if (walxrepeat < 0.0)
+		// For a negative repeat, u is mirrored: xrepeat - u * xrepeat
+		float uScale = (walxrepeat < 0.0) ? -xrepeat * FRACUNIT : xrepeat * FRACUNIT;
+		float uOffset = (walxrepeat < 0.0) ? xrepeat * FRACUNIT : 0.0f;
+		int x = x1;
+
+#ifndef NO_SSE
 		{
-			for (int x = x1; x < x2; x++)
+			__m128 muOverZ = _mm_set1_ps(uOverZ);
+			__m128 minvZ = _mm_set1_ps(invZ);
+			__m128 muGradient = _mm_set1_ps(uGradient);
+			__m128 mzGradient = _mm_set1_ps(zGradient);
+			__m128 muScale = _mm_set1_ps(uScale);
+			__m128 muOffset = _mm_set1_ps(uOffset);
+			__m128 mdepthScale = _mm_set1_ps(depthScale);
+			__m128 mdepthOrg = _mm_set1_ps(depthOrg);
+			__m128 index[2] = { _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f), _mm_setr_ps(4.0f, 5.0f, 6.0f, 7.0f) };
+			for (; x + 8 <= x2; x += 8)
 			{
-				float u = uOverZ / invZ;
-
-				UPos[x] = (fixed_t)((xrepeat - u * xrepeat) * FRACUNIT);
-				VStep[x] = depthOrg + u * depthScale;
-
-				uOverZ += uGradient;
-				invZ += zGradient;
+				__m128 base = _mm_set1_ps((float)(x - x1));
+				for (int i = 0; i < 2; i++)
+				{
+					__m128 t = _mm_add_ps(base, index[i]);
+					__m128 u = _mm_div_ps(_mm_add_ps(muOverZ, _mm_mul_ps(t, muGradient)), _mm_add_ps(minvZ, _mm_mul_ps(t, mzGradient)));
+					_mm_storeu_si128((__m128i*)&UPos[x + i * 4], _mm_cvttps_epi32(_mm_add_ps(muOffset, _mm_mul_ps(u, muScale))));
+					_mm_storeu_ps(&VStep[x + i * 4], _mm_add_ps(mdepthOrg, _mm_mul_ps(u, mdepthScale)));
+				}
 			}
 		}
-		else
-		{
-			for (int x = x1; x < x2; x++)
-			{
-				float u = uOverZ / invZ;
+#endif
 
-				UPos[x] = (fixed_t)(u * xrepeat * FRACUNIT);
-				VStep[x] = depthOrg + u * depthScale;
+		for (; x < x2; x++)
+		{
+			float t = (float)(x - x1);
+			float u = (uOverZ + t * uGradient) / (invZ + t * zGradient);
 
-				uOverZ += uGradient;
-				invZ += zGradient;
-			}
+			UPos[x] = (fixed_t)(uOffset + u * uScale);
+			VStep[x] = depthOrg + u * depthScale;
 		}
 	}
 
@@ -216,29 +268,38 @@ namespace swrenderer
 		float zGradient = WallT.InvZstep;
 		float xrepeat = (float)fabs(walxrepeat);
 
-		if (walxrepeat < 0.0f)
+		float uScale = xrepeat * FRACUNIT;
+		float uOffset = (walxrepeat < 0.0f) ? -xrepeat * FRACUNIT : 0.0f;
+		int x = x1;
+
+#ifndef NO_SSE
 		{
-			for (int x = x1; x < x2; x++)
+			__m128 muOverZ = _mm_set1_ps(uOverZ);
+			__m128 minvZ = _mm_set1_ps(invZ);
+			__m128 muGradient = _mm_set1_ps(uGradient);
+			__m128 mzGradient = _mm_set1_ps(zGradient);
+			__m128 muScale = _mm_set1_ps(uScale);
+			__m128 muOffset = _mm_set1_ps(uOffset);
+			__m128 index[2] = { _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f), _mm_setr_ps(4.0f, 5.0f, 6.0f, 7.0f) };
+			for (; x + 8 <= x2; x += 8)
 			{
-				float u = uOverZ / invZ * xrepeat - xrepeat;
-
-				UPos[x] = (fixed_t)(u * FRACUNIT);
-
-				uOverZ += uGradient;
-				invZ += zGradient;
+				__m128 base = _mm_set1_ps((float)(x - x1));
+				for (int i = 0; i < 2; i++)
+				{
+					__m128 t = _mm_add_ps(base, index[i]);
+					__m128 u = _mm_div_ps(_mm_add_ps(muOverZ, _mm_mul_ps(t, muGradient)), _mm_add_ps(minvZ, _mm_mul_ps(t, mzGradient)));
+					_mm_storeu_si128((__m128i*)&UPos[x + i * 4], _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(u, muScale), muOffset)));
+				}
 			}
 		}
-		else
-		{
-			for (int x = x1; x < x2; x++)
-			{
-				float u = uOverZ / invZ * xrepeat;
+#endif
 
-				UPos[x] = (fixed_t)(u * FRACUNIT);
+		for (; x < x2; x++)
+		{
+			float t = (float)(x - x1);
+			float u = (uOverZ + t * uGradient) / (invZ + t * zGradient);
 
-				uOverZ += uGradient;
-				invZ += zGradient;
-			}
+			UPos[x] = (fixed_t)(u * uScale + uOffset);
 		}
 	}
 }
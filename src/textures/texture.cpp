@@ -47,6 +47,11 @@
 #include "textures/textures.h"
 #include "v_palette.h"
 #include "g_levellocals.h"
+#include "stats.h"
+
+#ifndef NO_SSE
+#include <emmintrin.h>
+#endif
 
 typedef FTexture * (*CreateFunc)(FileReader & file, int lumpnum);
 
@@ -174,11 +179,18 @@ FTexture::~FTexture ()
 	FTexture *link = Wads.GetLinkedTexture(SourceLump);
 	if (link == this) Wads.SetLinkedTexture(SourceLump, NULL);
 	KillNative();
+	TexMan.ReleasePixelCache(this);
 }
 
 void FTexture::Unload()
 {
 	PixelsBgra = std::vector<uint32_t>();
+	TexMan.ReleasePixelCache(this);
+}
+
+size_t FTexture::GetPixelBufferSize()
+{
+	return PixelsBgra.size() * sizeof(uint32_t);
 }
 
 const uint32_t *FTexture::GetColumnBgra(unsigned int column, const Span **spans_out)
@@ -197,6 +209,7 @@ const uint32_t *FTexture::GetPixelsBgra()
 {
 	if (PixelsBgra.empty() || CheckModified(DefaultRenderStyle()))
 	{
+		// GetColumn already counts this access.
 		if (!GetColumn(DefaultRenderStyle(), 0, nullptr))
 			return nullptr;
 
@@ -204,6 +217,11 @@ const uint32_t *FTexture::GetPixelsBgra()
 		bitmap.Create(GetWidth(), GetHeight());
 		CopyTrueColorPixels(&bitmap, 0, 0);
 		GenerateBgraFromBitmap(bitmap);
+		TexMan.UpdatePixelCache(this);
+	}
+	else
+	{
+		TexMan.TouchPixelCache(this, false);
 	}
 	return PixelsBgra.data();
 }
@@ -250,13 +268,67 @@ void FTexture::CalcBitSize ()
 	HeightBits = i;
 }
 
-FTexture::Span **FTexture::CreateSpans (const uint8_t *pixels) const
-{
-	Span **spans, *span;
+//===========================================================================
+//
+// FTexture :: GetSpansSize
+//
+// Returns the amount of memory FillSpans needs for this texture's pixels.
+//
+//===========================================================================
 
+size_t FTexture::GetSpansSize (const uint8_t *pixels) const
+{
 	if (!bMasked)
 	{ // Texture does not have holes, so it can use a simpler span structure
-		spans = (Span **)M_Malloc (sizeof(Span*)*Width + sizeof(Span)*2);
+		return sizeof(Span*)*Width + sizeof(Span)*2;
+	}
+
+	// Texture might have holes, so count the spans of a complete span structure
+	int numcols = Width;
+	int numrows = Height;
+	int numspans = numcols;	// One span to terminate each column
+	const uint8_t *data_p = pixels;
+	bool newspan;
+	int x, y;
+
+	for (x = numcols; x > 0; --x)
+	{
+		newspan = true;
+		for (y = numrows; y > 0; --y)
+		{
+
+			if (*data_p++ == 0)
+			{
+				if (!newspan)
+				{
+					newspan = true;
+				}
+			}
+			else if (newspan)
+			{
+				newspan = false;
+				numspans++;
+			}
+		}
+	}
+	return sizeof(Span*)*numcols + sizeof(Span)*numspans;
+}
+
+//===========================================================================
+//
+// FTexture :: FillSpans
+//
+// Builds the span lists in a buffer of at least GetSpansSize bytes.
+// The column pointers come first, followed by the spans themselves.
+//
+//===========================================================================
+
+FTexture::Span **FTexture::FillSpans (void *buffer, const uint8_t *pixels) const
+{
+	Span **spans = (Span **)buffer, *span;
+
+	if (!bMasked)
+	{
 		span = (Span *)&spans[Width];
 		for (int x = 0; x < Width; ++x)
 		{
@@ -268,42 +340,13 @@ FTexture::Span **FTexture::CreateSpans (const uint8_t *pixels) const
 		span[1].TopOffset = 0;
 	}
 	else
-	{ // Texture might have holes, so build a complete span structure
+	{
 		int numcols = Width;
 		int numrows = Height;
-		int numspans = numcols;	// One span to terminate each column
 		const uint8_t *data_p;
 		bool newspan;
 		int x, y;
 
-		data_p = pixels;
-
-		// Count the number of spans in this texture
-		for (x = numcols; x > 0; --x)
-		{
-			newspan = true;
-			for (y = numrows; y > 0; --y)
-			{
-
-				if (*data_p++ == 0)
-				{
-					if (!newspan)
-					{
-						newspan = true;
-					}
-				}
-				else if (newspan)
-				{
-					newspan = false;
-					numspans++;
-				}
-			}
-		}
-
-		// Allocate space for the spans
-		spans = (Span **)M_Malloc (sizeof(Span*)*numcols + sizeof(Span)*numspans);
-
-		// Fill in the spans
 		for (x = 0, span = (Span *)&spans[numcols], data_p = pixels; x < numcols; ++x)
 		{
 			newspan = true;
@@ -344,6 +387,11 @@ FTexture::Span **FTexture::CreateSpans (const uint8_t *pixels) const
 	return spans;
 }
 
+FTexture::Span **FTexture::CreateSpans (const uint8_t *pixels) const
+{
+	return FillSpans(M_Malloc(GetSpansSize(pixels)), pixels);
+}
+
 void FTexture::FreeSpans (Span **spans) const
 {
 	M_Free (spans);
@@ -391,7 +439,17 @@ int FTexture::MipmapLevels() const
 	return MAX(widthbits, heightbits);
 }
 
-void FTexture::GenerateBgraMipmaps()
+//===========================================================================
+//
+// Mipmap generation for the truecolor software renderer
+//
+// The mip chain is built in linear color space (gamma 2.2), with a box
+// filter for downscaling followed by a slight sharpening pass. All data
+// is stored column-major, like the pixel buffers themselves.
+//
+//===========================================================================
+
+namespace
 {
 	struct Color4f
 	{
@@ -406,110 +464,362 @@ void FTexture::GenerateBgraMipmaps()
 		Color4f operator-(float s) const { return Color4f{ a - s, r - s, g - s, b - s }; }
 	};
 
-	int levels = MipmapLevels();
-	std::vector<Color4f> image(PixelsBgra.size());
-
-	// Convert to normalized linear colorspace
+	// Replaces the powf calls for converting between sRGB and linear space.
+	// Thresholds[i] is the smallest linear value that gets rounded to i.
+	struct FMipmapGammaTables
 	{
-		for (int x = 0; x < Width; x++)
+		float ToLinear[256];
+		float Thresholds[256];
+
+		FMipmapGammaTables()
 		{
-			for (int y = 0; y < Height; y++)
+			Thresholds[0] = 0.0f;
+			for (int i = 0; i < 256; i++)
 			{
-				uint32_t c8 = PixelsBgra[x * Height + y];
-				Color4f c;
-				c.a = powf(APART(c8) * (1.0f / 255.0f), 2.2f);
-				c.r = powf(RPART(c8) * (1.0f / 255.0f), 2.2f);
-				c.g = powf(GPART(c8) * (1.0f / 255.0f), 2.2f);
-				c.b = powf(BPART(c8) * (1.0f / 255.0f), 2.2f);
-				image[x * Height + y] = c;
+				ToLinear[i] = powf(i * (1.0f / 255.0f), 2.2f);
+				if (i > 0) Thresholds[i] = powf((i - 0.5f) * (1.0f / 255.0f), 2.2f);
 			}
 		}
+
+		uint32_t ToByte(float c) const
+		{
+			uint32_t v = 0;
+			for (uint32_t step = 128; step > 0; step >>= 1)
+			{
+				if (v + step < 256 && c >= Thresholds[v + step]) v += step;
+			}
+			return v;
+		}
+
+		Color4f Linearize(uint32_t c8) const
+		{
+			return Color4f{ ToLinear[APART(c8)], ToLinear[RPART(c8)], ToLinear[GPART(c8)], ToLinear[BPART(c8)] };
+		}
+
+		uint32_t Delinearize(const Color4f &c) const
+		{
+			return (ToByte(c.a) << 24) | (ToByte(c.r) << 16) | (ToByte(c.g) << 8) | ToByte(c.b);
+		}
+	};
+
+	const FMipmapGammaTables &GetMipmapGammaTables()
+	{
+		static FMipmapGammaTables tables;
+		return tables;
 	}
 
-	// Generate mipmaps
+	const float MipmapSharpen = 0.08f;
+
+	void DownscaleMipmap(const Color4f *src, int srcw, int srch, Color4f *dest, int w, int h)
 	{
-		std::vector<Color4f> smoothed(Width * Height);
-		Color4f *src = image.data();
-		Color4f *dest = src + Width * Height;
-		for (int i = 1; i < levels; i++)
+		for (int x = 0; x < w; x++)
 		{
-			int srcw = MAX(Width >> (i - 1), 1);
-			int srch = MAX(Height >> (i - 1), 1);
-			int w = MAX(Width >> i, 1);
-			int h = MAX(Height >> i, 1);
+			int sx0 = x * 2;
+			int sx1 = MIN((x + 1) * 2, srcw - 1);
+			for (int y = 0; y < h; y++)
+			{
+				int sy0 = y * 2;
+				int sy1 = MIN((y + 1) * 2, srch - 1);
 
-			// Downscale
-			for (int x = 0; x < w; x++)
+				Color4f src00 = src[sy0 + sx0 * srch];
+				Color4f src01 = src[sy1 + sx0 * srch];
+				Color4f src10 = src[sy0 + sx1 * srch];
+				Color4f src11 = src[sy1 + sx1 * srch];
+				dest[y + x * h] = (src00 + src01 + src10 + src11) * 0.25f;
+			}
+		}
+	}
+
+	// Sharpen filter with a 3x3 kernel
+	void SharpenMipmap(Color4f *dest, Color4f *smoothed, int w, int h)
+	{
+		for (int x = 0; x < w; x++)
+		{
+			for (int y = 0; y < h; y++)
 			{
-				int sx0 = x * 2;
-				int sx1 = MIN((x + 1) * 2, srcw - 1);
-				for (int y = 0; y < h; y++)
+				Color4f c = { 0.0f, 0.0f, 0.0f, 0.0f };
+				for (int kx = -1; kx < 2; kx++)
 				{
-					int sy0 = y * 2;
-					int sy1 = MIN((y + 1) * 2, srch - 1);
+					for (int ky = -1; ky < 2; ky++)
+					{
+						int a = y + ky;
+						int b = x + kx;
+						if (a < 0) a = h - 1;
+						if (a == h) a = 0;
+						if (b < 0) b = w - 1;
+						if (b == w) b = 0;
+						c = c + dest[a + b * h];
+					}
+				}
+				smoothed[y + x * h] = c * (1.0f / 9.0f);
+			}
+		}
+		for (int j = 0; j < w * h; j++)
+			dest[j] = dest[j] + (dest[j] - smoothed[j]) * MipmapSharpen;
+	}
 
-					Color4f src00 = src[sy0 + sx0 * srch];
-					Color4f src01 = src[sy1 + sx0 * srch];
-					Color4f src10 = src[sy0 + sx1 * srch];
-					Color4f src11 = src[sy1 + sx1 * srch];
-					Color4f c = (src00 + src01 + src10 + src11) * 0.25f;
+#ifndef NO_SSE
+	// SSE2 versions of the above. Color4f is 16 bytes, so each texel fits into one register.
+	// The buffers come from std::vector and are not guaranteed to be 16 byte aligned.
 
-					dest[y + x * h] = c;
-				}
+	void DownscaleMipmapSSE(const Color4f *src, int srcw, int srch, Color4f *dest, int w, int h)
+	{
+		__m128 quarter = _mm_set1_ps(0.25f);
+		for (int x = 0; x < w; x++)
+		{
+			const float *col0 = &src[x * 2 * srch].a;
+			const float *col1 = &src[MIN((x + 1) * 2, srcw - 1) * srch].a;
+			float *out = &dest[x * h].a;
+			for (int y = 0; y < h; y++)
+			{
+				int sy0 = y * 8;
+				int sy1 = MIN((y + 1) * 2, srch - 1) * 4;
+				__m128 sum = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(col0 + sy0), _mm_loadu_ps(col0 + sy1)), _mm_add_ps(_mm_loadu_ps(col1 + sy0), _mm_loadu_ps(col1 + sy1)));
+				_mm_storeu_ps(out + y * 4, _mm_mul_ps(sum, quarter));
 			}
+		}
+	}
 
-			// Sharpen filter with a 3x3 kernel:
-			for (int x = 0; x < w; x++)
+	void SharpenMipmapSSE(Color4f *dest, Color4f *smoothed, int w, int h)
+	{
+		__m128 ninth = _mm_set1_ps(1.0f / 9.0f);
+		for (int x = 0; x < w; x++)
+		{
+			const float *cols[3] =
+			{
+				&dest[(x == 0 ? w - 1 : x - 1) * h].a,
+				&dest[x * h].a,
+				&dest[(x + 1 == w ? 0 : x + 1) * h].a
+			};
+			float *out = &smoothed[x * h].a;
+			for (int y = 0; y < h; y++)
 			{
-				for (int y = 0; y < h; y++)
+				int y0 = (y == 0 ? h - 1 : y - 1) * 4;
+				int y1 = y * 4;
+				int y2 = (y + 1 == h ? 0 : y + 1) * 4;
+				__m128 c = _mm_setzero_ps();
+				for (int k = 0; k < 3; k++)
 				{
-					Color4f c = { 0.0f, 0.0f, 0.0f, 0.0f };
-					for (int kx = -1; kx < 2; kx++)
-					{
-						for (int ky = -1; ky < 2; ky++)
-						{
-							int a = y + ky;
-							int b = x + kx;
-							if (a < 0) a = h - 1;
-							if (a == h) a = 0;
-							if (b < 0) b = w - 1;
-							if (b == w) b = 0;
-							c = c + dest[a + b * h];
-						}
-					}
-					c = c * (1.0f / 9.0f);
-					smoothed[y + x * h] = c;
+					c = _mm_add_ps(c, _mm_loadu_ps(cols[k] + y0));
+					c = _mm_add_ps(c, _mm_loadu_ps(cols[k] + y1));
+					c = _mm_add_ps(c, _mm_loadu_ps(cols[k] + y2));
 				}
+				_mm_storeu_ps(out + y1, _mm_mul_ps(c, ninth));
 			}
-			float k = 0.08f;
-			for (int j = 0; j < w * h; j++)
-				dest[j] = dest[j] + (dest[j] - smoothed[j]) * k;
+		}
 
-			src = dest;
-			dest += w * h;
+		__m128 k = _mm_set1_ps(MipmapSharpen);
+		float *d = &dest[0].a;
+		const float *s = &smoothed[0].a;
+		for (int j = 0; j < w * h * 4; j += 4)
+		{
+			__m128 c = _mm_loadu_ps(d + j);
+			c = _mm_add_ps(c, _mm_mul_ps(_mm_sub_ps(c, _mm_loadu_ps(s + j)), k));
+			_mm_storeu_ps(d + j, c);
 		}
 	}
+#endif
 
-	// Convert to bgra8 sRGB colorspace
+	// Fills in all mip levels after the first in a buffer laid out like
+	// the one created by FTexture::CreatePixelsBgraWithMipmaps.
+	void GenerateLinearMipmaps(uint32_t *pixels, int width, int height, int levels, bool simd)
 	{
-		Color4f *src = image.data() + Width * Height;
-		uint32_t *dest = PixelsBgra.data() + Width * Height;
+		const FMipmapGammaTables &tables = GetMipmapGammaTables();
+
+		int buffersize = 0;
+		for (int i = 0; i < levels; i++)
+		{
+			buffersize += MAX(width >> i, 1) * MAX(height >> i, 1);
+		}
+		std::vector<Color4f> image(buffersize);
+
+		// Convert to normalized linear colorspace
+		for (int j = 0; j < width * height; j++)
+		{
+			image[j] = tables.Linearize(pixels[j]);
+		}
+
+		// Generate mipmaps
+		std::vector<Color4f> smoothed(width * height);
+		Color4f *src = image.data();
+		Color4f *dest = src + width * height;
 		for (int i = 1; i < levels; i++)
 		{
-			int w = MAX(Width >> i, 1);
-			int h = MAX(Height >> i, 1);
-			for (int j = 0; j < w * h; j++)
+			int srcw = MAX(width >> (i - 1), 1);
+			int srch = MAX(height >> (i - 1), 1);
+			int w = MAX(width >> i, 1);
+			int h = MAX(height >> i, 1);
+
+#ifndef NO_SSE
+			if (simd)
 			{
-				uint32_t a = (uint32_t)clamp(powf(MAX(src[j].a, 0.0f), 1.0f / 2.2f) * 255.0f + 0.5f, 0.0f, 255.0f);
-				uint32_t r = (uint32_t)clamp(powf(MAX(src[j].r, 0.0f), 1.0f / 2.2f) * 255.0f + 0.5f, 0.0f, 255.0f);
-				uint32_t g = (uint32_t)clamp(powf(MAX(src[j].g, 0.0f), 1.0f / 2.2f) * 255.0f + 0.5f, 0.0f, 255.0f);
-				uint32_t b = (uint32_t)clamp(powf(MAX(src[j].b, 0.0f), 1.0f / 2.2f) * 255.0f + 0.5f, 0.0f, 255.0f);
-				dest[j] = (a << 24) | (r << 16) | (g << 8) | b;
+				DownscaleMipmapSSE(src, srcw, srch, dest, w, h);
+				SharpenMipmapSSE(dest, smoothed.data(), w, h);
 			}
-			src += w * h;
+			else
+#endif
+			{
+				DownscaleMipmap(src, srcw, srch, dest, w, h);
+				SharpenMipmap(dest, smoothed.data(), w, h);
+			}
+
+			src = dest;
 			dest += w * h;
 		}
+
+		// Convert to bgra8 sRGB colorspace
+		for (int j = width * height; j < buffersize; j++)
+		{
+			pixels[j] = tables.Delinearize(image[j]);
+		}
+	}
+}
+
+//===========================================================================
+//
+// The mipmap generator as it was before the gamma tables and the SSE2
+// kernels. Only used as the baseline in mipmapbench.
+//
+//===========================================================================
+
+static void GeneratePowfMipmaps(uint32_t *pixels, int width, int height, int levels)
+{
+	int buffersize = 0;
+	for (int i = 0; i < levels; i++)
+	{
+		buffersize += MAX(width >> i, 1) * MAX(height >> i, 1);
 	}
+	std::vector<Color4f> image(buffersize);
+
+	for (int j = 0; j < width * height; j++)
+	{
+		uint32_t c8 = pixels[j];
+		Color4f c;
+		c.a = powf(APART(c8) * (1.0f / 255.0f), 2.2f);
+		c.r = powf(RPART(c8) * (1.0f / 255.0f), 2.2f);
+		c.g = powf(GPART(c8) * (1.0f / 255.0f), 2.2f);
+		c.b = powf(BPART(c8) * (1.0f / 255.0f), 2.2f);
+		image[j] = c;
+	}
+
+	std::vector<Color4f> smoothed(width * height);
+	Color4f *src = image.data();
+	Color4f *dest = src + width * height;
+	for (int i = 1; i < levels; i++)
+	{
+		int srcw = MAX(width >> (i - 1), 1);
+		int srch = MAX(height >> (i - 1), 1);
+		int w = MAX(width >> i, 1);
+		int h = MAX(height >> i, 1);
+		DownscaleMipmap(src, srcw, srch, dest, w, h);
+		SharpenMipmap(dest, smoothed.data(), w, h);
+		src = dest;
+		dest += w * h;
+	}
+
+	for (int j = width * height; j < buffersize; j++)
+	{
+		uint32_t a = (uint32_t)clamp(powf(MAX(image[j].a, 0.0f), 1.0f / 2.2f) * 255.0f + 0.5f, 0.0f, 255.0f);
+		uint32_t r = (uint32_t)clamp(powf(MAX(image[j].r, 0.0f), 1.0f / 2.2f) * 255.0f + 0.5f, 0.0f, 255.0f);
+		uint32_t g = (uint32_t)clamp(powf(MAX(image[j].g, 0.0f), 1.0f / 2.2f) * 255.0f + 0.5f, 0.0f, 255.0f);
+		uint32_t b = (uint32_t)clamp(powf(MAX(image[j].b, 0.0f), 1.0f / 2.2f) * 255.0f + 0.5f, 0.0f, 255.0f);
+		pixels[j] = (a << 24) | (r << 16) | (g << 8) | b;
+	}
+}
+
+void FTexture::GenerateBgraMipmaps()
+{
+	GenerateLinearMipmaps(PixelsBgra.data(), Width, Height, MipmapLevels(), true);
+}
+
+//===========================================================================
+//
+// Compares the scalar and the SSE2 mipmap generator with the old powf
+// version on the given texture or, if none is given, on all wall textures
+// and flats.
+//
+//===========================================================================
+
+CCMD(mipmapbench)
+{
+	TArray<FTexture *> textures;
+	if (argv.argc() > 1)
+	{
+		FTexture *tex = TexMan.FindTexture(argv[1], ETextureType::Any);
+		if (tex == nullptr)
+		{
+			Printf("Unknown texture '%s'\n", argv[1]);
+			return;
+		}
+		textures.Push(tex);
+	}
+	else
+	{
+		for (int i = 0; i < TexMan.NumTextures(); i++)
+		{
+			FTexture *tex = TexMan.ByIndex(i);
+			if (tex->UseType == ETextureType::Wall || tex->UseType == ETextureType::Flat) textures.Push(tex);
+		}
+	}
+
+	cycle_t powftime, scalartime, simdtime;
+	powftime.Reset();
+	scalartime.Reset();
+	simdtime.Reset();
+	int mismatches = 0;
+	int count = 0;
+
+	for (auto tex : textures)
+	{
+		const uint32_t *src = tex->GetPixelsBgra();
+		if (src == nullptr || !tex->Mipmapped()) continue;
+
+		int width = tex->GetWidth();
+		int height = tex->GetHeight();
+		int levels = 0;
+		while ((width >> levels) != 0 || (height >> levels) != 0) levels++;
+
+		int buffersize = 0;
+		for (int i = 0; i < levels; i++)
+		{
+			buffersize += MAX(width >> i, 1) * MAX(height >> i, 1);
+		}
+		std::vector<uint32_t> baseline(src, src + buffersize), scalar(src, src + buffersize), simd(src, src + buffersize);
+
+		powftime.Clock();
+		GeneratePowfMipmaps(baseline.data(), width, height, levels);
+		powftime.Unclock();
+
+		scalartime.Clock();
+		GenerateLinearMipmaps(scalar.data(), width, height, levels, false);
+		scalartime.Unclock();
+
+		simdtime.Clock();
+		GenerateLinearMipmaps(simd.data(), width, height, levels, true);
+		simdtime.Unclock();
+
+		// The filters sum in a different order and the tables round slightly
+		// differently at the boundaries, so allow for off-by-one results.
+		auto differs = [](uint32_t a, uint32_t b)
+		{
+			return abs(int(APART(a)) - int(APART(b))) > 1 || abs(int(RPART(a)) - int(RPART(b))) > 1 ||
+				abs(int(GPART(a)) - int(GPART(b))) > 1 || abs(int(BPART(a)) - int(BPART(b))) > 1;
+		};
+		for (int j = 0; j < buffersize; j++)
+		{
+			if (differs(baseline[j], scalar[j]) || differs(baseline[j], simd[j]))
+			{
+				mismatches++;
+				break;
+			}
+		}
+		count++;
+	}
+
+	Printf("%d textures: powf %.2f ms, scalar %.2f ms, SSE2 %.2f ms, %d mismatches\n", count, powftime.TimeMS(), scalartime.TimeMS(), simdtime.TimeMS(), mismatches);
+#ifdef NO_SSE
+	Printf("This build does not use SSE2. Both timings are of the scalar code.\n");
+#endif
 }
 
 void FTexture::GenerateBgraMipmapsFast()
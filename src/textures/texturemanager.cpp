@@ -54,9 +54,13 @@
 #include "r_sky.h"
 #include "textures/textures.h"
 #include "vm.h"
+#include "stats.h"
 
 FTextureManager TexMan;
 
+// Upper limit in megabytes for decoded software renderer pixel buffers. 0 means unlimited.
+CVAR(Int, r_texturebudget, 0, CVAR_ARCHIVE | CVAR_GLOBALCONFIG)
+
 CUSTOM_CVAR(Bool, vid_nopalsubstitutions, false, CVAR_ARCHIVE)
 {
 	// This is in case the sky texture has been substituted.
@@ -374,6 +378,124 @@ void FTextureManager::UnloadAll ()
 	}
 }
 
+//==========================================================================
+//
+// FTextureManager :: AddToPixelCache
+//
+// Called when a texture has (re)created one of its pixel buffers.
+//
+//==========================================================================
+
+void FTextureManager::AddToPixelCache(FTexture *tex)
+{
+	PixelCacheMisses++;
+	UpdatePixelCache(tex);
+}
+
+//==========================================================================
+//
+// FTextureManager :: UpdatePixelCache
+//
+// Accounts for a changed buffer size without counting another miss.
+//
+//==========================================================================
+
+void FTextureManager::UpdatePixelCache(FTexture *tex)
+{
+	size_t size = tex->GetPixelBufferSize();
+
+	if (tex->PixelCacheIndex < 0)
+	{
+		tex->PixelCacheIndex = PixelCache.Push(tex);
+	}
+	PixelCacheBytes += size - tex->PixelCacheBytes;
+	tex->PixelCacheBytes = size;
+}
+
+//==========================================================================
+//
+// FTextureManager :: ReleasePixelCache
+//
+// Called by FTexture::Unload once all pixel buffers have been freed.
+//
+//==========================================================================
+
+void FTextureManager::ReleasePixelCache(FTexture *tex)
+{
+	int index = tex->PixelCacheIndex;
+	if (index < 0) return;
+
+	FTexture *last = PixelCache.Last();
+	PixelCache[index] = last;
+	last->PixelCacheIndex = index;
+	PixelCache.Pop();
+
+	PixelCacheBytes -= tex->PixelCacheBytes;
+	tex->PixelCacheBytes = 0;
+	tex->PixelCacheIndex = -1;
+}
+
+//==========================================================================
+//
+// FTextureManager :: TrimPixelCache
+//
+// Unloads the least recently used textures until the decoded pixel
+// buffers fit into r_texturebudget again. Textures that have been used
+// since the last call are never evicted because a renderer may still
+// hold pointers into their buffers. This must be called once per frame,
+// after all rendering is complete.
+//
+//==========================================================================
+
+void FTextureManager::TrimPixelCache()
+{
+	size_t budget = size_t(MAX<int>(r_texturebudget, 0)) << 20;
+
+	if (budget > 0 && PixelCacheBytes > budget)
+	{
+		TArray<FTexture *> candidates;
+		candidates.Grow(PixelCache.Size());
+		for (auto tex : PixelCache)
+		{
+			if (tex->PixelCacheFrame != PixelCacheFrame) candidates.Push(tex);
+		}
+		std::sort(candidates.begin(), candidates.end(), [](FTexture *a, FTexture *b)
+		{
+			return a->PixelCacheFrame < b->PixelCacheFrame;
+		});
+
+		for (auto tex : candidates)
+		{
+			if (PixelCacheBytes <= budget) break;
+			tex->Unload();
+			// Make sure the texture is gone, even if a subclass didn't release everything.
+			ReleasePixelCache(tex);
+			PixelCacheEvictions++;
+		}
+	}
+	PixelCacheFrame++;
+}
+
+//==========================================================================
+//
+// FTextureManager :: GetPixelCacheStats
+//
+//==========================================================================
+
+FString FTextureManager::GetPixelCacheStats()
+{
+	FString out;
+	out.Format("Textures: %u, %.2f MB of %d MB, hits: %u, misses: %u, evictions: %u",
+		PixelCache.Size(), PixelCacheBytes / 1048576., *r_texturebudget,
+		PixelCacheHits, PixelCacheMisses, PixelCacheEvictions);
+	return out;
+}
+
+ADD_STAT(texcache)
+{
+	return TexMan.GetPixelCacheStats();
+}
+
 //==========================================================================
 //
 // FTextureManager :: AddTexture
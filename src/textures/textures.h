@@ -392,6 +392,8 @@ protected:
 
 	Span **CreateSpans (const uint8_t *pixels) const;
 	void FreeSpans (Span **spans) const;
+	size_t GetSpansSize (const uint8_t *pixels) const;
+	Span **FillSpans (void *buffer, const uint8_t *pixels) const;
 	void CalcBitSize ();
 	void CopyInfo(FTexture *other)
 	{
@@ -416,11 +418,21 @@ protected:
 	void GenerateBgraMipmapsFast();
 	int MipmapLevels() const;
 
+	// Returns the number of bytes held by decoded pixel buffers that Unload() would free.
+	virtual size_t GetPixelBufferSize();
+
 private:
 	bool bSWSkyColorDone = false;
 	PalEntry FloorSkyColor;
 	PalEntry CeilingSkyColor;
 
+	// Bookkeeping for FTextureManager's pixel buffer budget
+	size_t PixelCacheBytes = 0;
+	int PixelCacheIndex = -1;
+	uint32_t PixelCacheFrame = 0;
+
+	friend class FTextureManager;
+
 public:
 	static void FlipSquareBlock (uint8_t *block, int x, int y);
 	static void FlipSquareBlockBgra (uint32_t *block, int x, int y);
@@ -590,6 +602,27 @@ public:
 
 	void UnloadAll ();
 
+	// Decoded pixel buffer budget for the software renderers.
+	// TouchPixelCache must be called once whenever a texture's pixel buffers are accessed,
+	// UpdatePixelCache when an access that was already counted created another buffer,
+	// TrimPixelCache only at a point where no renderer holds any pixel pointers.
+	void TouchPixelCache(FTexture *tex, bool created)
+	{
+		if (created)
+		{
+			AddToPixelCache(tex);
+		}
+		else if (tex->PixelCacheFrame != PixelCacheFrame)
+		{
+			PixelCacheHits++;
+		}
+		if (tex->PixelCacheFrame != PixelCacheFrame) tex->PixelCacheFrame = PixelCacheFrame;
+	}
+	void UpdatePixelCache(FTexture *tex);
+	void ReleasePixelCache(FTexture *tex);
+	void TrimPixelCache();
+	FString GetPixelCacheStats();
+
 	int NumTextures () const { return (int)Textures.Size(); }
 
 	void UpdateAnimations (uint64_t mstime);
@@ -629,6 +662,7 @@ private:
 	void ParseAnimatedDoor(FScanner &sc);
 
 	void InitPalettedVersions();
+	void AddToPixelCache(FTexture *tex);
 
 	// Switches
 
@@ -654,6 +688,11 @@ private:
 	TArray<FSwitchDef *> mSwitchDefs;
 	TArray<FDoorAnimation> mAnimatedDoors;
 
+	TArray<FTexture *> PixelCache;
+	size_t PixelCacheBytes = 0;
+	uint32_t PixelCacheFrame = 1;
+	unsigned PixelCacheHits = 0, PixelCacheMisses = 0, PixelCacheEvictions = 0;
+
 public:
 	TArray<FAnimDef *> mAnimations;
 
@@ -672,6 +711,10 @@ protected:
 	uint8_t *Pixeldata[2] = { nullptr, nullptr };
 	Span **Spandata[2] = { nullptr, nullptr };
 	uint8_t PixelsAreStatic = 0;	// can be set by subclasses which provide static pixel buffers.
+	uint8_t PixelsInBlock = 0;		// the pixel data was allocated by PackPixels, with room for the spans behind it.
+	uint8_t SpansInBlock = 0;		// the spans share their allocation with the pixel data.
+	size_t SpanReserve[2] = { 0, 0 };	// bytes reserved for the spans in a packed block
+	size_t SpanSize[2] = { 0, 0 };		// bytes of spans that have their own allocation
 
 	FWorldTexture(const char *name = nullptr, int lumpnum = -1);
 	~FWorldTexture();
@@ -679,8 +722,14 @@ protected:
 	const uint8_t *GetColumn(FRenderStyle style, unsigned int column, const Span **spans_out) override;
 	const uint8_t *GetPixels(FRenderStyle style) override;
 	void Unload() override;
+	size_t GetPixelBufferSize() override;
 	virtual uint8_t *MakeTexture(FRenderStyle style) = 0;
+	// Animated textures can rewrite their existing pixel buffer instead of making a new one.
+	virtual bool UpdateTexture(FRenderStyle style, uint8_t *pixels) { return false; }
 	void FreeAllSpans();
+	void PackPixels(int index);
+	Span **MakeSpans(int index);
+	void UpdateSpans(int index);
 };
 
 // A texture that doesn't really exist
@@ -718,6 +767,7 @@ protected:
 	FTexture *SourcePic;
 
 	uint8_t *MakeTexture (FRenderStyle style) override;
+	bool UpdateTexture(FRenderStyle style, uint8_t *pixels) override;
 	int NextPo2 (int v); // [mxd]
 	void SetupMultipliers (int width, int height); // [mxd]
 };
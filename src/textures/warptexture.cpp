@@ -85,6 +85,7 @@ const uint32_t *FWarpTexture::GetPixelsBgra()
 		}
 		GenerateBgraMipmapsFast();
 		GenTimeBgra = GenTime[0];
+		TexMan.UpdatePixelCache(this);	// GetPixels already counted this access.
 	}
 	return PixelsBgra.data();
 }
@@ -101,6 +102,15 @@ uint8_t *FWarpTexture::MakeTexture(FRenderStyle style)
 	return Pixels;
 }
 
+bool FWarpTexture::UpdateTexture(FRenderStyle style, uint8_t *pixels)
+{
+	uint64_t time = screen->FrameTime;
+	const uint8_t *otherpix = SourcePic->GetPixels(style);
+	WarpBuffer(pixels, otherpix, Width, Height, WidthOffsetMultiplier, HeightOffsetMultiplier, time, Speed, bWarped);
+	GenTime[!!(style.Flags & STYLEF_RedIsAlpha)] = time;
+	return true;
+}
+
 // [mxd] Non power of 2 textures need different offset multipliers, otherwise warp animation won't sync across texture
 void FWarpTexture::SetupMultipliers (int width, int height)
 {
@@ -35,6 +35,31 @@
 
 #include "textures.h"
 
+//==========================================================================
+//
+// 16 byte aligned allocations for the packed pixel blocks. The distance
+// to the start of the real allocation is stored in the byte before the
+// returned pointer.
+//
+//==========================================================================
+
+static uint8_t *AllocPixelBlock(size_t size)
+{
+	uint8_t *mem = new uint8_t[size + 16];
+	uint8_t *block = (uint8_t *)(((uintptr_t)mem + 16) & ~uintptr_t(15));
+	block[-1] = uint8_t(block - mem);
+	return block;
+}
+
+static void FreePixelBlock(uint8_t *block)
+{
+	if (block != nullptr) delete[] (block - block[-1]);
+}
+
+static size_t PackedPixelSize(int width, int height)
+{
+	return (size_t(width) * height + 15) & ~size_t(15);
+}
 
 //==========================================================================
 //
@@ -71,10 +96,93 @@ void FWorldTexture::FreeAllSpans()
 	{
 		if (Spandata[i] != nullptr)
 		{
-			FreeSpans (Spandata[i]);
+			// Packed spans get freed together with the pixels.
+			if (!(SpansInBlock & (1 << i))) FreeSpans (Spandata[i]);
 			Spandata[i] = nullptr;
 		}
+		SpanSize[i] = 0;
+	}
+	SpansInBlock = 0;
+}
+
+//==========================================================================
+//
+// Moves freshly created pixel data into a 16 byte aligned block with room
+// for its span lists behind it, so that the drawers find a column and its
+// spans in the same block of memory. The spans themselves are only built
+// by MakeSpans when they are first asked for.
+//
+//==========================================================================
+
+void FWorldTexture::PackPixels(int index)
+{
+	uint8_t *pixels = Pixeldata[index];
+	if (pixels == nullptr || (PixelsAreStatic & (1 << index))) return;
+
+	if (Spandata[index] != nullptr && !(SpansInBlock & (1 << index)))
+	{
+		FreeSpans(Spandata[index]);
+	}
+	Spandata[index] = nullptr;
+	SpansInBlock &= ~(1 << index);
+	SpanSize[index] = 0;
+
+	size_t pixelsize = PackedPixelSize(Width, Height);
+	SpanReserve[index] = GetSpansSize(pixels);
+	uint8_t *block = AllocPixelBlock(pixelsize + SpanReserve[index]);
+	memcpy(block, pixels, Width * Height);
+	PixelsInBlock |= 1 << index;
+
+	delete[] pixels;
+	Pixeldata[index] = block;
+}
+
+//==========================================================================
+//
+// Builds the spans for the current pixel data, in the space PackPixels
+// reserved if it still fits. bMasked can change after the pixels were
+// made, in which case the spans get their own allocation.
+//
+//==========================================================================
+
+FTexture::Span **FWorldTexture::MakeSpans(int index)
+{
+	const uint8_t *pixels = Pixeldata[index];
+	size_t size = GetSpansSize(pixels);
+
+	if ((PixelsInBlock & (1 << index)) && size <= SpanReserve[index])
+	{
+		SpansInBlock |= 1 << index;
+		return FillSpans(Pixeldata[index] + PackedPixelSize(Width, Height), pixels);
+	}
+	SpanSize[index] = size;
+	return CreateSpans(pixels);
+}
+
+//==========================================================================
+//
+// Brings existing spans up to date after UpdateTexture rewrote the pixels.
+// Without holes they don't depend on the pixels at all. Otherwise they are
+// rebuilt in place if they still fit, or left to MakeSpans.
+//
+//==========================================================================
+
+void FWorldTexture::UpdateSpans(int index)
+{
+	if (Spandata[index] == nullptr || !bMasked) return;
+
+	if ((SpansInBlock & (1 << index)) && GetSpansSize(Pixeldata[index]) <= SpanReserve[index])
+	{
+		FillSpans(Spandata[index], Pixeldata[index]);
+		return;
+	}
+	if (!(SpansInBlock & (1 << index)))
+	{
+		FreeSpans(Spandata[index]);
 	}
+	Spandata[index] = nullptr;
+	SpansInBlock &= ~(1 << index);
+	SpanSize[index] = 0;
 }
 
 //==========================================================================
@@ -87,12 +195,23 @@ void FWorldTexture::Unload ()
 {
 	for(int i = 0; i < 2; i++)
 	{
-		if (!(PixelsAreStatic & (1 << i)))
+		if (PixelsInBlock & (1 << i))
+		{
+			FreePixelBlock(Pixeldata[i]);
+			SpanReserve[i] = 0;
+		}
+		else if (!(PixelsAreStatic & (1 << i)))
 		{
 			delete[] Pixeldata[i];
 		}
 		Pixeldata[i] = nullptr;
+		if (SpansInBlock & (1 << i))
+		{
+			Spandata[i] = nullptr;
+		}
 	}
+	PixelsInBlock = 0;
+	SpansInBlock = 0;
 	FTexture::Unload();
 }
 
@@ -102,6 +221,30 @@ void FWorldTexture::Unload ()
 //
 //==========================================================================
 
+size_t FWorldTexture::GetPixelBufferSize()
+{
+	size_t size = FTexture::GetPixelBufferSize();
+	for(int i = 0; i < 2; i++)
+	{
+		if (PixelsInBlock & (1 << i))
+		{
+			size += PackedPixelSize(Width, Height) + SpanReserve[i];
+		}
+		else if (Pixeldata[i] != nullptr && !(PixelsAreStatic & (1 << i)))
+		{
+			size += Width * Height;
+		}
+		size += SpanSize[i];
+	}
+	return size;
+}
+
+//==========================================================================
+//
+//
+//
+//==========================================================================
+
 const uint8_t *FWorldTexture::GetColumn(FRenderStyle style, unsigned int column, const Span **spans_out)
 {
 	int index = !!(style.Flags & STYLEF_RedIsAlpha);
@@ -121,7 +264,11 @@ const uint8_t *FWorldTexture::GetColumn(FRenderStyle style, unsigned int column,
 	{
 		if (Spandata[index] == nullptr)
 		{
-			Spandata[index] = CreateSpans (Pixeldata[index]);
+			Spandata[index] = MakeSpans(index);
+			if (!(SpansInBlock & (1 << index)))
+			{
+				TexMan.UpdatePixelCache(this);
+			}
 		}
 		*spans_out = Spandata[index][column];
 	}
@@ -136,15 +283,27 @@ const uint8_t *FWorldTexture::GetColumn(FRenderStyle style, unsigned int column,
 
 const uint8_t *FWorldTexture::GetPixels (FRenderStyle style)
 {
+	int index = !!(style.Flags & STYLEF_RedIsAlpha);
 	if (CheckModified(style))
 	{
-		Unload();
+		// Keep the packed block and its spans if the pixels can be rewritten in place.
+		if ((PixelsInBlock & (1 << index)) && UpdateTexture(style, Pixeldata[index]))
+		{
+			UpdateSpans(index);
+		}
+		else
+		{
+			Unload();
+		}
 	}
-	int index = !!(style.Flags & STYLEF_RedIsAlpha);
+	bool created = false;
 	if (Pixeldata[index] == nullptr)
 	{
 		Pixeldata[index] = MakeTexture (style);
+		PackPixels(index);
+		created = true;
 	}
+	TexMan.TouchPixelCache(this, created);
 	return Pixeldata[index];
 }
 